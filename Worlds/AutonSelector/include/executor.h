@@ -0,0 +1,465 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Autonomous Executor                             */
+/*                                                                           */
+/*  A routine is a table of steps, each with a duration worked out before    */
+/*  the match. The executor runs them against the 15 s budget and keeps      */
+/*  enough time back for the critical steps still to come (parking): an      */
+/*  optional step that does not fit is skipped, and an ordinary step that    */
+/*  runs into the time held back is cut short at that point.                 */
+/*                                                                           */
+/*  A table is written for one alliance and the other runs it mirrored, with */
+/*  every turn the other way. Where the field is not quite symmetric a step  */
+/*  can be given for one alliance only, and it runs exactly as written.      */
+/*                                                                           */
+/*  A group step runs the steps after it at the same time, each in its own   */
+/*  task, so the arm or a wait can overlap the drive. The group is over when */
+/*  its join rule says so, and any step still running is cut short.          */
+/*                                                                           */
+/*  A drive or arm step that stalls against something, or runs well past     */
+/*  the time it was expected to take, is given up on: the robot backs off    */
+/*  and the routine carries on with the next step.                           */
+/*---------------------------------------------------------------------------*/
+
+enum StepKind {
+  moveStep,     // value inches, speed max pct, minimum starting pct
+  turnStep,     // value wheel degrees, speed max pct
+  pivotStep,    // value back left degrees, speed rpm, minimum ms wait first
+  flywheelStep, // value rpm, 0 to let it coast, speed a FlywheelMode
+  intakeStep,   // value rpm, 0 to stop
+  armStep,      // value revs, speed rpm
+  waitStep,     // value ms
+  groupStep     // value how many of the next steps run at once, speed join
+};
+
+// What a flywheel step does with the two flywheel motors
+enum FlywheelMode {
+  flywheelBothMotors, // both spin at value, or coast at 0
+  flywheelTargetOnly, // only sets the target, like fwChange()
+  flywheelFirstOff    // fw coasts and fw2 drives the shaft on its own
+};
+
+// When a group of steps running at once is over
+enum JoinRule {
+  joinAll,  // every step is done
+  joinAny,  // one step is done, the rest are cut short
+  joinFirst // the group's first step is done, usually the drive
+};
+
+// A drive and each mechanism at most
+const int maxGroupSteps = 4;
+
+enum StepFlags {
+  optionalStep = 1, // skipped when it would eat into the time held back
+  criticalStep = 2, // always run, time is held back for it
+  coastStep = 4,    // the arm coasts once it gets there instead of holding
+  redOnlyStep = 8,  // only run on red, never mirrored
+  blueOnlyStep = 16 // only run on blue, never mirrored
+};
+
+enum Alliance { redAlliance, blueAlliance };
+
+struct Step {
+  uint8_t kind;
+  uint8_t flags;
+  uint16_t expectedMs; // 0 to have it worked out from the step
+  float value;
+  float speed;
+  float minimum;
+};
+
+// Builders so a routine table reads like the code it replaces
+constexpr Step moveBy(float inches, float maxPct = 100, float minimumPct = 60) {
+  return Step{moveStep, 0, 0, inches, maxPct, minimumPct};
+}
+
+constexpr Step turnBy(float degrees, float maxPct) {
+  return Step{turnStep, 0, 0, degrees, maxPct, 0};
+}
+
+// The encoder turns of the old turnL/turnR, positive degrees turn right
+constexpr Step pivotBy(float degrees, float rpm, float waitMs) {
+  return Step{pivotStep, 0, 0, degrees, rpm, waitMs};
+}
+
+constexpr Step flywheelAt(float rpm) {
+  return Step{flywheelStep, 0, 0, rpm, flywheelBothMotors, 0};
+}
+
+// Like fwChange: a spinning flywheel motor changes speed, a stopped one stays
+// put
+constexpr Step flywheelTarget(float rpm) {
+  return Step{flywheelStep, 0, 0, rpm, flywheelTargetOnly, 0};
+}
+
+// Like fw.stop(coast) on its own: the shaft slows with only fw2 driving it
+constexpr Step flywheelFirstCoasts() {
+  return Step{flywheelStep, 0, 0, 0, flywheelFirstOff, 0};
+}
+
+constexpr Step intakeAt(float rpm) { return Step{intakeStep, 0, 0, rpm, 0, 0}; }
+
+constexpr Step armBy(float revs, float rpm) {
+  return Step{armStep, 0, 0, revs, rpm, 0};
+}
+
+constexpr Step waitFor(float ms) { return Step{waitStep, 0, 0, ms, 0, 0}; }
+
+// The next members steps run at once
+constexpr Step together(int members, JoinRule join = joinAll) {
+  return Step{groupStep, 0, 0, (float)members, (float)join, 0};
+}
+
+constexpr Step skippable(const Step &step) {
+  return Step{step.kind, (uint8_t)(step.flags | optionalStep), step.expectedMs,
+              step.value, step.speed, step.minimum};
+}
+
+constexpr Step critical(const Step &step) {
+  return Step{step.kind, (uint8_t)(step.flags | criticalStep), step.expectedMs,
+              step.value, step.speed, step.minimum};
+}
+
+constexpr Step coasting(const Step &step) {
+  return Step{step.kind, (uint8_t)(step.flags | coastStep), step.expectedMs,
+              step.value, step.speed, step.minimum};
+}
+
+// A step for one alliance, usually next to the other alliance's version
+constexpr Step redOnly(const Step &step) {
+  return Step{step.kind, (uint8_t)(step.flags | redOnlyStep), step.expectedMs,
+              step.value, step.speed, step.minimum};
+}
+
+constexpr Step blueOnly(const Step &step) {
+  return Step{step.kind, (uint8_t)(step.flags | blueOnlyStep), step.expectedMs,
+              step.value, step.speed, step.minimum};
+}
+
+// A measured duration in place of the worked out one
+constexpr Step expecting(const Step &step, uint16_t ms) {
+  return Step{step.kind, step.flags, ms, step.value, step.speed, step.minimum};
+}
+
+struct Routine {
+  const char *name;
+  const Step *steps;
+  int count;
+  Alliance alliance; // the one the table is written for
+};
+
+// The step as alliance runs it from a table written for the other one: turns
+// go the other way. Returns false if the step belongs to the other alliance.
+inline bool mirrorStep(const Step &step, Alliance alliance, bool mirror,
+                       Step &out) {
+  if ((step.flags & redOnlyStep) && alliance != redAlliance)
+    return false;
+  if ((step.flags & blueOnlyStep) && alliance != blueAlliance)
+    return false;
+
+  out = step;
+  bool fixed = step.flags & (redOnlyStep | blueOnlyStep);
+  if (mirror && !fixed && (step.kind == turnStep || step.kind == pivotStep))
+    out.value = -step.value;
+  return true;
+}
+
+enum StepOutcome {
+  stepPending,
+  stepDone,
+  stepCut,     // stopped at its deadline
+  stepSkipped, // optional and there was no time for it
+  stepStalled, // stopped because it was not moving
+  stepTimedOut // stopped because it took far longer than expected
+};
+
+// Runs one step. Returns stepDone, stepCut if deadlineMs came first or
+// stepStalled if it gave up on a mechanism that would not move.
+typedef StepOutcome (*StepRunner)(const Step &step, uint32_t deadlineMs);
+
+// How long a step should take in ms, for steps without expectedMs
+typedef uint32_t (*StepEstimator)(const Step &step);
+
+// Gets the robot clear after a step stalled or timed out
+typedef void (*StepRecovery)(const Step &step, uint32_t deadlineMs);
+
+class Executor;
+
+// A step of a group, run by one of the worker tasks
+struct GroupWorker {
+  Executor *executor;
+  int index;
+  uint32_t deadline;
+  volatile bool done;
+};
+
+GroupWorker groupWorkers[maxGroupSteps];
+
+// Set once a group has joined, until its steps still running have stopped
+volatile bool groupCut = false;
+
+// Step runners check this along with their deadline
+inline bool groupJoined() { return groupCut; }
+
+// vex::task entry points take no arguments, so each worker gets its own
+template <int slot> int groupEntry();
+
+int (*const groupEntries[maxGroupSteps])(void) = {
+    groupEntry<0>, groupEntry<1>, groupEntry<2>, groupEntry<3>};
+
+class Executor {
+public:
+  static const int maxSteps = 64;
+
+  // Held back on top of the estimates for critical steps, which may run long
+  static const uint32_t criticalMargin = 250;
+
+  // How often a running group is looked at
+  static const uint32_t groupPoll = 5;
+
+  // A drive or arm step is given up on after half as long again as expected
+  // plus this
+  static const uint32_t timeoutSlack = 250;
+
+  Executor(StepRunner runner, StepEstimator estimator,
+           StepRecovery recovery = NULL)
+      : runner(runner), estimator(estimator), recovery(recovery),
+        routine(NULL), side(redAlliance), stepCount(0), startedAt(0),
+        finishedAt(0) {}
+
+  // Takes the steps alliance runs, mirrored if need be, and works out every
+  // step's duration and the time to hold back after it. Done in pre_auton so
+  // none of it happens in the timed period.
+  bool prepare(const Routine &next, Alliance alliance) {
+    routine = NULL;
+    stepCount = 0;
+    bool mirror = next.alliance != alliance;
+    for (int i = 0; i < next.count; i++) {
+      Step step;
+      if (!mirrorStep(next.steps[i], alliance, mirror, step))
+        continue;
+      if (stepCount == maxSteps)
+        return false;
+      steps[stepCount++] = step;
+    }
+
+    for (int i = 0; i < stepCount; i++) {
+      const Step &step = steps[i];
+      expected[i] = step.expectedMs != 0 ? step.expectedMs : estimator(step);
+      outcomes[i] = stepPending;
+      actual[i] = 0;
+    }
+
+    // a group takes as long as its join rule waits for
+    for (int i = 0; i < stepCount; i++) {
+      if (steps[i].kind != groupStep)
+        continue;
+      int members = (int)steps[i].value;
+      if (members < 1 || members > maxGroupSteps || i + members >= stepCount)
+        return false;
+      if (steps[i].expectedMs == 0)
+        expected[i] = groupTime(i + 1, members, (JoinRule)(int)steps[i].speed);
+    }
+
+    reserve[stepCount] = 0;
+    for (int i = stepCount - 1; i >= 0; i--) {
+      reserve[i] = reserve[i + 1];
+      if (steps[i].flags & criticalStep)
+        reserve[i] += expected[i] + criticalMargin;
+    }
+
+    routine = &next;
+    side = alliance;
+    return true;
+  }
+
+  // Runs the prepared routine with budgetMs from now
+  void run(uint32_t budgetMs) {
+    if (routine == NULL)
+      return;
+
+    startedAt = vex::timer::system();
+    uint32_t end = startedAt + budgetMs;
+
+    for (int i = 0; i < stepCount; i++) {
+      const Step &step = steps[i];
+      uint32_t now = vex::timer::system();
+
+      uint32_t deadline = end;
+      if (!(step.flags & criticalStep)) {
+        deadline = end - reserve[i + 1];
+        if ((int32_t)(deadline - now) < 0)
+          deadline = now;
+      }
+
+      int members = step.kind == groupStep ? (int)step.value : 0;
+      if ((step.flags & optionalStep) &&
+          (int32_t)(deadline - now) < (int32_t)expected[i]) {
+        for (int m = 0; m <= members; m++)
+          outcomes[i + m] = stepSkipped;
+        i += members;
+        continue;
+      }
+
+      if (members > 0) {
+        runGroup(i + 1, members, (JoinRule)(int)step.speed, deadline);
+        actual[i] = vex::timer::system() - now;
+        outcomes[i] = stepDone;
+        i += members;
+        continue;
+      }
+
+      runAt(i, deadline);
+    }
+
+    finishedAt = vex::timer::system();
+  }
+
+  // Runs step index with its timeout and backs off if it does not finish.
+  // Used by run() and the group workers.
+  void runAt(int index, uint32_t deadlineMs) {
+    const Step &step = steps[index];
+    uint32_t start = vex::timer::system();
+
+    uint32_t stepDeadline = deadlineMs;
+    bool timed = step.kind == moveStep || step.kind == turnStep ||
+                 step.kind == pivotStep || step.kind == armStep;
+    uint32_t timeoutAt = start + expected[index] + expected[index] / 2 +
+                         timeoutSlack;
+    if (timed && (int32_t)(timeoutAt - deadlineMs) < 0)
+      stepDeadline = timeoutAt;
+
+    StepOutcome outcome = runner(step, stepDeadline);
+    if (outcome == stepCut && stepDeadline != deadlineMs &&
+        (int32_t)(vex::timer::system() - timeoutAt) >= 0)
+      outcome = stepTimedOut;
+    actual[index] = vex::timer::system() - start;
+    outcomes[index] = outcome;
+
+    if ((outcome == stepStalled || outcome == stepTimedOut) &&
+        recovery != NULL)
+      recovery(step, deadlineMs);
+  }
+
+  // Whether prepare() last got this routine ready for alliance
+  bool prepared(const Routine &which, Alliance alliance) const {
+    return routine == &which && side == alliance;
+  }
+
+  int count(StepOutcome outcome) const {
+    int total = 0;
+    for (int i = 0; routine != NULL && i < stepCount; i++)
+      if (outcomes[i] == outcome)
+        total++;
+    return total;
+  }
+
+  // Time the whole routine is expected to take
+  uint32_t expectedTotal() const {
+    uint32_t total = 0;
+    for (int i = 0; routine != NULL && i < stepCount; i++) {
+      total += expected[i];
+      if (steps[i].kind == groupStep)
+        i += (int)steps[i].value;
+    }
+    return total;
+  }
+
+  uint32_t elapsed() const { return finishedAt - startedAt; }
+
+  // Expected against actual time per step as csv, returns bytes written
+  int32_t save(vex::brain &brain, const char *name) const {
+    static const char *const outcomeNames[] = {
+        "pending", "done", "cut", "skipped", "stalled", "timed out"};
+    static char text[maxSteps * 40 + 64];
+    if (routine == NULL)
+      return 0;
+
+    int length = snprintf(text, sizeof(text),
+                          "step,kind,expected_ms,actual_ms,outcome\n");
+    for (int i = 0; i < stepCount; i++)
+      length += snprintf(text + length, sizeof(text) - length,
+                         "%d,%d,%u,%u,%s\n", i, steps[i].kind,
+                         (unsigned)expected[i], (unsigned)actual[i],
+                         outcomeNames[outcomes[i]]);
+
+    if (!brain.SDcard.isInserted())
+      return 0;
+    return brain.SDcard.savefile(name, (uint8_t *)text, length);
+  }
+
+private:
+  StepRunner runner;
+  StepEstimator estimator;
+  StepRecovery recovery;
+  const Routine *routine;
+  Alliance side;
+
+  Step steps[maxSteps]; // as they run for side
+  int stepCount;
+  uint32_t expected[maxSteps];
+  uint32_t reserve[maxSteps + 1]; // time held back for critical steps from i
+  uint32_t actual[maxSteps];
+  uint8_t outcomes[maxSteps];
+  uint32_t startedAt;
+  uint32_t finishedAt;
+
+  uint32_t groupTime(int first, int members, JoinRule join) const {
+    uint32_t time = expected[first];
+    for (int m = 1; m < members && join != joinFirst; m++) {
+      uint32_t step = expected[first + m];
+      time = join == joinAll ? std::max(time, step) : std::min(time, step);
+    }
+    return time;
+  }
+
+  // Starts each step of a group in a worker, then waits for the join rule
+  // and for every step to have stopped
+  void runGroup(int first, int members, JoinRule join, uint32_t deadline) {
+    groupCut = false;
+    for (int m = 0; m < members; m++) {
+      GroupWorker &worker = groupWorkers[m];
+      worker.executor = this;
+      worker.index = first + m;
+      worker.deadline = deadline;
+      worker.done = false;
+      __sync_synchronize();
+      vex::task start(groupEntries[m]);
+    }
+
+    int running = members;
+    while (running > 0) {
+      vex::task::sleep(groupPoll);
+      running = 0;
+      for (int m = 0; m < members; m++)
+        running += !groupWorkers[m].done;
+
+      bool joined = join == joinAll    ? running == 0
+                    : join == joinAny ? running < members
+                                      : groupWorkers[0].done;
+      if (joined)
+        groupCut = true;
+    }
+    groupCut = false;
+    __sync_synchronize(); // see what the workers wrote
+  }
+};
+
+template <int slot> int groupEntry() {
+  GroupWorker &worker = groupWorkers[slot];
+  worker.executor->runAt(worker.index, worker.deadline);
+  __sync_synchronize(); // results written before done is seen
+  worker.done = true;
+  return (0);
+}
+
+#endif
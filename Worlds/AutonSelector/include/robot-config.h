@@ -8,12 +8,37 @@
 //
 using namespace vex;
 vex::brain Brain;
-vex::motor Leftfront (vex::PORT1, vex::gearSetting::ratio18_1,false);
-vex::motor Rightfront (vex::PORT2, vex::gearSetting::ratio18_1,true);
-vex::motor Rightpuncher (vex::PORT3, vex::gearSetting::ratio36_1,false);
-vex::motor Flipper (vex::PORT4, vex::gearSetting::ratio18_1,false);
-vex::motor Leftpuncher (vex::PORT8, vex::gearSetting::ratio36_1,false);
-vex::motor Leftback (vex::PORT9, vex::gearSetting::ratio18_1,false);
-vex::motor Rightback (vex::PORT10, vex::gearSetting::ratio18_1,true);
-vex::gyro Gyro1( Brain.ThreeWirePort.C);
-vex::controller Controller1;
\ No newline at end of file
+
+//Drive
+
+//LeftFront
+vex::motor lf = vex::motor(vex::PORT3, false);
+//LeftBack
+vex::motor lb = vex::motor(vex::PORT11, false);
+
+//RightFront
+vex::motor rf = vex::motor(vex::PORT9, true);
+//RightBack
+vex::motor rb = vex::motor(vex::PORT20, true);
+
+//Flywheel
+vex::motor fw = vex::motor(vex::PORT1, vex::gearSetting::ratio6_1, false);
+vex::motor fw2 = vex::motor(vex::PORT2, vex::gearSetting::ratio6_1, true);
+
+//Intake
+vex::motor in = vex::motor(vex::PORT10, vex::gearSetting::ratio6_1, false);
+
+//Descorer/Flipper
+vex::motor arm = vex::motor(vex::PORT19, vex::gearSetting::ratio36_1, false);
+
+//Gyro
+vex::gyro Gyro = vex::gyro(Brain.ThreeWirePort.G);
+
+//Sonar/Distance
+vex::sonar Sonar = vex::sonar(Brain.ThreeWirePort.A);
+
+//Line Sensor
+vex::line Line = vex::line(Brain.ThreeWirePort.C);
+
+vex::controller Controller1 = vex::controller(vex::controllerType::primary);
+vex::controller Controller2 = vex::controller(vex::controllerType::partner);
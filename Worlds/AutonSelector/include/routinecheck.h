@@ -0,0 +1,229 @@
+#ifndef ROUTINECHECK_H
+#define ROUTINECHECK_H
+
+#include "executor.h"
+
+/*---------------------------------------------------------------------------*/
+/*                              Routine Checks                               */
+/*                                                                           */
+/*  Checks the compiler runs over every routine table, so a bad number stops */
+/*  the build instead of showing up on the field. gnu++11 constexpr          */
+/*  functions are a single return statement, so each check walks the table   */
+/*  by recursion. The time estimate here is plainer than the executor's:     */
+/*  drives run at the average of their starting and top speeds.              */
+/*---------------------------------------------------------------------------*/
+
+// Limits of the robot the steps have to stay within
+constexpr float fieldLength = 144;    // inches
+constexpr float driveMaxRpm = 200;    // 18:1 drive motors
+constexpr float flywheelMaxRpm = 600; // 6:1
+constexpr float intakeMaxRpm = 600;   // 6:1
+constexpr float armMaxRpm = 100;      // 36:1
+constexpr float armLowest = -0.05;    // revs from where it starts
+constexpr float armHighest = 0.5;     // revs from where it starts
+constexpr float routineBudget = 15000; // ms
+
+// The motion constants main.cpp estimates with
+constexpr float checkWheelCircumference = 3.14159 * 4;
+constexpr float checkTurnMinimum = 20; // pct
+constexpr float checkSettleTime = 50;  // ms after a move or turn
+
+constexpr float magnitude(float x) { return x < 0 ? -x : x; }
+
+constexpr bool runsFor(const Step &step, Alliance alliance) {
+  return !((step.flags & redOnlyStep) && alliance != redAlliance) &&
+         !((step.flags & blueOnlyStep) && alliance != blueAlliance);
+}
+
+constexpr bool flagsValid(const Step &step) {
+  return (step.flags & (redOnlyStep | blueOnlyStep)) !=
+             (redOnlyStep | blueOnlyStep) &&
+         (step.flags & (optionalStep | criticalStep)) !=
+             (optionalStep | criticalStep) &&
+         (!(step.flags & coastStep) || step.kind == armStep);
+}
+
+constexpr bool stepInRange(const Step &step) {
+  return step.kind == moveStep
+             ? step.value != 0 && magnitude(step.value) <= fieldLength &&
+                   step.speed > 0 && step.speed <= 100 &&
+                   step.minimum >= 0 && step.minimum <= step.speed
+         : step.kind == turnStep
+             ? step.value != 0 && magnitude(step.value) <= 1080 &&
+                   step.speed > 0 && step.speed <= 100
+         : step.kind == pivotStep
+             ? step.value != 0 && magnitude(step.value) <= 1080 &&
+                   step.speed > 0 && step.speed <= driveMaxRpm &&
+                   step.minimum >= 0 && step.minimum <= routineBudget
+         : step.kind == flywheelStep
+             ? step.value >= 0 && step.value <= flywheelMaxRpm &&
+                   (step.speed == flywheelBothMotors ||
+                    step.speed == flywheelTargetOnly ||
+                    (step.speed == flywheelFirstOff && step.value == 0))
+         : step.kind == intakeStep
+             ? magnitude(step.value) <= intakeMaxRpm
+         : step.kind == armStep
+             ? step.value != 0 && magnitude(step.value) <= 1 &&
+                   step.speed > 0 && step.speed <= armMaxRpm
+         : step.kind == waitStep
+             ? step.value > 0 && step.value <= routineBudget
+         : step.kind == groupStep
+             ? step.value >= 2 && step.value <= maxGroupSteps &&
+                   step.value == (int)step.value &&
+                   (step.speed == joinAll || step.speed == joinAny ||
+                    step.speed == joinFirst) &&
+                   step.minimum == 0
+             : false;
+}
+
+constexpr bool stepsValid(const Step *steps, int count, int i = 0) {
+  return i == count || (stepInRange(steps[i]) && flagsValid(steps[i]) &&
+                        stepsValid(steps, count, i + 1));
+}
+
+// The drive counts as one mechanism however it moves
+constexpr int mechanism(const Step &step) {
+  return step.kind == turnStep || step.kind == pivotStep ? (int)moveStep
+                                                          : step.kind;
+}
+
+constexpr bool usedBefore(const Step *steps, int from, int to, int used) {
+  return from < to && (mechanism(steps[from]) == used ||
+                       usedBefore(steps, from + 1, to, used));
+}
+
+// A group's steps are plain steps, each for a different mechanism, and run
+// for both alliances so mirroring cannot change what is in the group
+constexpr bool membersValid(const Step *steps, int first, int end, int j) {
+  return j == end ||
+         (steps[j].kind != groupStep &&
+          (steps[j].flags &
+           (optionalStep | criticalStep | redOnlyStep | blueOnlyStep)) == 0 &&
+          !usedBefore(steps, first, j, mechanism(steps[j])) &&
+          membersValid(steps, first, end, j + 1));
+}
+
+constexpr bool groupsValid(const Step *steps, int count, int i = 0) {
+  return i >= count ? true
+         : steps[i].kind != groupStep
+             ? groupsValid(steps, count, i + 1)
+         : steps[i].value < 2 || steps[i].value > maxGroupSteps ||
+                   i + (int)steps[i].value >= count
+             ? false
+             : membersValid(steps, i + 1, i + 1 + (int)steps[i].value,
+                            i + 1) &&
+                   groupsValid(steps, count, i + 1 + (int)steps[i].value);
+}
+
+// ms for revs of wheel travel at the average of two speeds in pct
+constexpr float driveTime(float revs, float maxPct, float minimumPct) {
+  return revs / ((maxPct + minimumPct) / 200 * driveMaxRpm) * 60000 +
+         checkSettleTime;
+}
+
+constexpr float stepTime(const Step &step) {
+  return step.expectedMs != 0 ? step.expectedMs
+         : step.kind == moveStep
+             ? driveTime(magnitude(step.value) / checkWheelCircumference,
+                         step.speed, step.minimum)
+         : step.kind == turnStep
+             ? driveTime(magnitude(step.value) / 360, step.speed,
+                         checkTurnMinimum)
+         : step.kind == pivotStep
+             ? magnitude(step.value) / 360 / step.speed * 60000 +
+                   step.minimum + 150
+         : step.kind == armStep
+             ? magnitude(step.value) / step.speed * 60000
+         : step.kind == waitStep ? step.value
+                                 : 0;
+}
+
+constexpr float longest(const Step *steps, int from, int to) {
+  return from == to ? 0
+                    : stepTime(steps[from]) > longest(steps, from + 1, to)
+                          ? stepTime(steps[from])
+                          : longest(steps, from + 1, to);
+}
+
+constexpr float shortest(const Step *steps, int from, int to) {
+  return from + 1 == to ? stepTime(steps[from])
+         : stepTime(steps[from]) < shortest(steps, from + 1, to)
+             ? stepTime(steps[from])
+             : shortest(steps, from + 1, to);
+}
+
+// A group lasts as long as its join rule waits for
+constexpr float groupTime(const Step &group, const Step *members) {
+  return group.expectedMs != 0         ? group.expectedMs
+         : group.speed == joinFirst ? stepTime(members[0])
+         : group.speed == joinAny   ? shortest(members, 0, (int)group.value)
+                                    : longest(members, 0, (int)group.value);
+}
+
+// Estimated ms for everything alliance runs, skippable steps included. A
+// group the alliance does not run leaves its steps to run one by one.
+constexpr float routineTime(const Step *steps, int count, Alliance alliance,
+                            int i = 0) {
+  return i >= count ? 0
+         : !runsFor(steps[i], alliance)
+             ? routineTime(steps, count, alliance, i + 1)
+         : steps[i].kind == groupStep
+             ? (i + (int)steps[i].value < count
+                    ? groupTime(steps[i], steps + i + 1)
+                    : 0) +
+                   routineTime(steps, count, alliance,
+                               i + 1 + (int)steps[i].value)
+             : stepTime(steps[i]) + routineTime(steps, count, alliance, i + 1);
+}
+
+// A flywheel target only changes the speed of a flywheel motor that is
+// spinning, so one after both were stopped would do nothing. fw and fw2 are
+// followed apart, since a table can stop fw and leave fw2 spinning.
+constexpr bool flywheelSequenced(const Step *steps, int count,
+                                 Alliance alliance, bool fwSpinning = false,
+                                 bool fw2Spinning = false, int i = 0) {
+  return i == count ? true
+         : !runsFor(steps[i], alliance) || steps[i].kind != flywheelStep
+             ? flywheelSequenced(steps, count, alliance, fwSpinning,
+                                 fw2Spinning, i + 1)
+         : steps[i].speed == flywheelTargetOnly
+             ? (fwSpinning || fw2Spinning) &&
+                   flywheelSequenced(steps, count, alliance, fwSpinning,
+                                     fw2Spinning, i + 1)
+         : steps[i].speed == flywheelFirstOff
+             ? flywheelSequenced(steps, count, alliance, false, fw2Spinning,
+                                 i + 1)
+             : flywheelSequenced(steps, count, alliance, steps[i].value != 0,
+                                 steps[i].value != 0, i + 1);
+}
+
+// The arm's moves add up to a position it can reach from where it starts
+constexpr bool armInReach(const Step *steps, int count, Alliance alliance,
+                          float at = 0, int i = 0) {
+  return i == count ? true
+         : !runsFor(steps[i], alliance) || steps[i].kind != armStep
+             ? armInReach(steps, count, alliance, at, i + 1)
+         : at + steps[i].value < armLowest || at + steps[i].value > armHighest
+             ? false
+             : armInReach(steps, count, alliance, at + steps[i].value, i + 1);
+}
+
+// A table and its length, for the checks below
+#define TABLE(steps) steps, sizeof(steps) / sizeof(Step)
+
+#define CHECK_ALLIANCE(steps, alliance)                                        \
+  static_assert(routineTime(TABLE(steps), alliance) < routineBudget,           \
+                #steps " takes longer than autonomous on " #alliance);         \
+  static_assert(flywheelSequenced(TABLE(steps), alliance),                     \
+                #steps " sets a target for a stopped flywheel on " #alliance); \
+  static_assert(armInReach(TABLE(steps), alliance),                            \
+                #steps " moves the arm out of reach on " #alliance)
+
+// Every table is checked for both alliances, since either may mirror it
+#define CHECK_ROUTINE(steps)                                                   \
+  static_assert(stepsValid(TABLE(steps)), #steps " has a step out of range");  \
+  static_assert(groupsValid(TABLE(steps)), #steps " has a bad group");         \
+  CHECK_ALLIANCE(steps, redAlliance);                                          \
+  CHECK_ALLIANCE(steps, blueAlliance)
+
+#endif
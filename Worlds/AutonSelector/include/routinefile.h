@@ -0,0 +1,137 @@
+#ifndef ROUTINEFILE_H
+#define ROUTINEFILE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "executor.h"
+#include "routinecheck.h"
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                          Routines on the SD card                          */
+/*                                                                           */
+/*  A routine can be tuned between matches by copying a file onto the SD     */
+/*  card instead of rebuilding. CompileRoutine.py turns the text form, the   */
+/*  same builder calls as routines.h, into                                   */
+/*                                                                           */
+/*    "RTNE" | version u8 | alliance u8 | step count u16 | steps ...         */
+/*                                                                           */
+/*  with every field little endian and each step packed into 12 bytes:       */
+/*  kind u8, flags u8, expected ms u16, value i32 in thousandths, speed u16  */
+/*  and minimum u16. A file is only used if it passes the same checks the    */
+/*  compiler runs over the built in tables.                                  */
+/*---------------------------------------------------------------------------*/
+
+class RoutineFile {
+public:
+  static const uint8_t version = 1;
+  static const int headerSize = 8;
+  static const int stepSize = 12;
+  // both alliances' steps of a routine written with overrides
+  static const int maxSteps = 96;
+
+  RoutineFile() : problem("not loaded") {
+    loaded.name = NULL;
+    loaded.steps = steps;
+    loaded.count = 0;
+    loaded.alliance = redAlliance;
+  }
+
+  // Loads and checks a routine, leaves this one empty on failure
+  bool load(vex::brain &brain, const char *fileName, const char *name) {
+    loaded.name = NULL;
+    loaded.count = 0;
+    if (!brain.SDcard.isInserted()) {
+      problem = "no SD card";
+      return false;
+    }
+
+    int32_t length = brain.SDcard.loadfile(fileName, data, sizeof(data));
+    if (length < headerSize || memcmp(data, "RTNE", 4) != 0 ||
+        data[4] != version || data[5] > blueAlliance) {
+      problem = "not a routine";
+      return false;
+    }
+
+    int count = get16(data + 6);
+    if (count > maxSteps || length != headerSize + count * stepSize) {
+      problem = "wrong length";
+      return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+      const uint8_t *p = data + headerSize + i * stepSize;
+      steps[i].kind = p[0];
+      steps[i].flags = p[1];
+      steps[i].expectedMs = get16(p + 2);
+      steps[i].value = (int32_t)get32(p + 4) / 1000.0f;
+      steps[i].speed = get16(p + 8);
+      steps[i].minimum = get16(p + 10);
+    }
+
+    Alliance written = (Alliance)data[5];
+    if (!stepsValid(steps, count))
+      problem = "step out of range";
+    else if (!groupsValid(steps, count))
+      problem = "bad group";
+    else if (!fitsBoth(count))
+      problem = "too long";
+    else if (!flywheelSequenced(steps, count, redAlliance) ||
+             !flywheelSequenced(steps, count, blueAlliance))
+      problem = "flywheel order";
+    else if (!armInReach(steps, count, redAlliance) ||
+             !armInReach(steps, count, blueAlliance))
+      problem = "arm out of reach";
+    else if (!runsWithin(count))
+      problem = "too many steps";
+    else
+      problem = NULL;
+    if (problem != NULL)
+      return false;
+
+    loaded.name = name;
+    loaded.count = count;
+    loaded.alliance = written;
+    return true;
+  }
+
+  bool ready() const { return loaded.count > 0; }
+  const Routine &routine() const { return loaded; }
+
+  // Why the last load failed, for the warm-up screen
+  const char *why() const { return problem; }
+
+private:
+  uint8_t data[headerSize + maxSteps * stepSize];
+  Step steps[maxSteps];
+  Routine loaded;
+  const char *problem;
+
+  bool fitsBoth(int count) const {
+    return routineTime(steps, count, redAlliance) < routineBudget &&
+           routineTime(steps, count, blueAlliance) < routineBudget;
+  }
+
+  // What either alliance runs has to fit in the executor
+  bool runsWithin(int count) const {
+    int red = 0, blue = 0;
+    for (int i = 0; i < count; i++) {
+      red += runsFor(steps[i], redAlliance);
+      blue += runsFor(steps[i], blueAlliance);
+    }
+    return red <= Executor::maxSteps && blue <= Executor::maxSteps;
+  }
+
+  static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+  }
+
+  static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+  }
+};
+
+#endif
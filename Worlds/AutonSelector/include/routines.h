@@ -0,0 +1,303 @@
+#ifndef ROUTINES_H
+#define ROUTINES_H
+
+#include "executor.h"
+#include "routinecheck.h"
+
+/*---------------------------------------------------------------------------*/
+/*                                 Routines                                  */
+/*                                                                           */
+/*  The autonomous routines of the per-routine projects as step tables.      */
+/*  Every forward() there was followed by stopH(), which a move step does    */
+/*  itself. The settle pauses around turns may be skipped when time is       */
+/*  short and the final drive onto the platform is critical.                 */
+/*---------------------------------------------------------------------------*/
+
+// Written for red. Blue runs it mirrored, with its own distances where the
+// two were tuned apart.
+constexpr Step frontPark[] = {
+    flywheelAt(525),
+    armBy(0.21, 100),
+    waitFor(10),
+    moveBy(37.5, 100, 60),
+    intakeAt(600),
+    waitFor(300),
+    intakeAt(0),
+
+    redOnly(moveBy(-34, 85, 30)),
+    blueOnly(moveBy(-37, 85, 30)),
+    skippable(waitFor(200)),
+    redOnly(turnBy(-275, 70)),
+    blueOnly(turnBy(282, 70)),
+    skippable(waitFor(200)),
+    intakeAt(600),
+    waitFor(300),
+    intakeAt(0),
+
+    moveBy(24.5, 80, 40),
+    intakeAt(600),
+    waitFor(300),
+    moveBy(4.5, 50, 40),
+    armBy(-0.23, 100),
+    moveBy(-4.5, 50, 40),
+
+    skippable(waitFor(200)),
+    turnBy(275, 80),
+    skippable(waitFor(200)),
+    moveBy(4, 55, 40),
+    redOnly(armBy(0.21, 30)),
+    blueOnly(armBy(0.21, 25)),
+
+    skippable(waitFor(200)),
+    turnBy(275, 70),
+    skippable(waitFor(200)),
+    redOnly(moveBy(46, 100, 50)),
+    blueOnly(moveBy(45.8, 100, 50)),
+    skippable(waitFor(200)),
+    turnBy(-275, 70),
+    skippable(waitFor(200)),
+    redOnly(critical(moveBy(42.3, 100, 60))),
+    blueOnly(critical(moveBy(43.3, 100, 60))),
+};
+
+// Written for red, blue mirrored. Most of the drives were tuned separately
+// on each side, so they are given per alliance.
+constexpr Step frontNP[] = {
+    redOnly(flywheelAt(500)),
+    blueOnly(flywheelAt(525)),
+    armBy(0.22, 25),
+    waitFor(10),
+    redOnly(moveBy(42, 100, 60)),
+    blueOnly(moveBy(37.5, 100, 50)),
+    intakeAt(600),
+    waitFor(300),
+    intakeAt(0),
+
+    redOnly(moveBy(-34.5, 97, 50)),
+    blueOnly(moveBy(-37, 85, 30)),
+    skippable(waitFor(200)),
+    redOnly(turnBy(-275, 70)),
+    blueOnly(turnBy(282, 70)),
+    skippable(waitFor(200)),
+    intakeAt(600),
+    waitFor(300),
+    intakeAt(0),
+
+    redOnly(moveBy(25, 60, 40)),
+    blueOnly(moveBy(24.5, 80, 40)),
+    intakeAt(600),
+    waitFor(300),
+    redOnly(moveBy(4.1, 50, 40)),
+    blueOnly(moveBy(4.5, 50, 40)),
+    armBy(-0.22, 25),
+    redOnly(moveBy(-3, 50, 50)),
+    blueOnly(moveBy(-4.5, 50, 40)),
+
+    skippable(waitFor(200)),
+    redOnly(turnBy(270, 70)),
+    blueOnly(turnBy(-275, 80)),
+    skippable(waitFor(200)),
+    redOnly(moveBy(4.65, 50, 50)),
+    blueOnly(moveBy(4, 55, 40)),
+    redOnly(armBy(0.22, 25)),
+    blueOnly(armBy(0.21, 25)),
+
+    skippable(waitFor(200)),
+    turnBy(177, 70),
+    skippable(waitFor(200)),
+    redOnly(moveBy(27.5, 100, 60)),
+    blueOnly(moveBy(27.3, 100, 60)),
+    coasting(armBy(-0.2, 37)),
+    waitFor(150),
+    intakeAt(0),
+    armBy(0.18, 80),
+
+    skippable(waitFor(200)),
+    redOnly(turnBy(-372, 70)),
+    blueOnly(turnBy(378, 70)),
+    skippable(waitFor(200)),
+    intakeAt(600),
+    waitFor(500),
+    turnBy(-9, 70),
+    skippable(waitFor(200)),
+};
+
+constexpr Step redFarNP[] = {
+    flywheelAt(440),
+    armBy(0.22, 25),
+    waitFor(5),
+    moveBy(23, 95, 50),
+    pivotBy(-173, 70, 20),
+    moveBy(4, 80, 50),
+    coasting(armBy(-0.2, 37)),
+    waitFor(150),
+    intakeAt(600),
+    moveBy(-1.5, 80, 50),
+    intakeAt(0),
+
+    skippable(waitFor(200)),
+    turnBy(-33, 70),
+    skippable(waitFor(200)),
+    intakeAt(600),
+    waitFor(350),
+    intakeAt(0),
+
+    // fw coasts and fw2 carries the flywheel on its own from here on
+    flywheelFirstCoasts(),
+    flywheelTarget(390),
+    waitFor(2500),
+    intakeAt(600),
+    waitFor(425),
+    moveBy(-3, 70, 50),
+
+    skippable(waitFor(200)),
+    turnBy(228, 70),
+    skippable(waitFor(200)),
+    flywheelTarget(570),
+    // the arm goes up on the way to the cap instead of before the drive
+    together(2),
+    moveBy(19, 70, 50),
+    armBy(0.22, 25),
+    waitFor(325),
+    intakeAt(0),
+    moveBy(-6, 70, 50),
+
+    skippable(waitFor(200)),
+    turnBy(-173, 70),
+    skippable(waitFor(200)),
+    intakeAt(600),
+    waitFor(700),
+    turnBy(340, 70),
+    skippable(waitFor(200)),
+    armBy(-0.22, 25),
+    moveBy(8.8, 70, 50),
+    armBy(0.22, 25),
+};
+
+constexpr Step blueFarNP[] = {
+    flywheelAt(440),
+    armBy(0.22, 25),
+    moveBy(40.2, 80, 50),
+    intakeAt(600),
+    waitFor(250),
+    intakeAt(0),
+    moveBy(-0.5, 100, 50),
+
+    skippable(waitFor(200)),
+    pivotBy(212, 50, 10),
+    intakeAt(600),
+    waitFor(325),
+    intakeAt(0),
+    flywheelTarget(390),
+    waitFor(2000),
+    intakeAt(600),
+    waitFor(1000),
+
+    pivotBy(-210, 50, 10),
+    moveBy(-17.5, 70, 50),
+    skippable(waitFor(200)),
+    pivotBy(179, 50, 10),
+    skippable(waitFor(200)),
+    armBy(-0.16, 25),
+    waitFor(250),
+    intakeAt(0),
+    pivotBy(-5, 50, 200),
+    intakeAt(600),
+};
+
+constexpr Step redFarPark[] = {
+    flywheelAt(440),
+    armBy(0.22, 25),
+    waitFor(5),
+    moveBy(23, 95, 50),
+    pivotBy(-173, 70, 20),
+    moveBy(4, 80, 50),
+    coasting(armBy(-0.2, 37)),
+    waitFor(150),
+    intakeAt(600),
+    moveBy(-1.5, 80, 50),
+    intakeAt(0),
+
+    skippable(waitFor(200)),
+    turnBy(-33, 70),
+    skippable(waitFor(200)),
+    intakeAt(600),
+    waitFor(350),
+    intakeAt(0),
+
+    // fw coasts and fw2 carries the flywheel on its own from here on
+    flywheelFirstCoasts(),
+    flywheelTarget(395),
+    waitFor(2500),
+    intakeAt(600),
+    waitFor(425),
+    moveBy(-3, 70, 50),
+
+    skippable(waitFor(200)),
+    turnBy(228, 70),
+    skippable(waitFor(200)),
+    flywheelTarget(560),
+    // the arm goes up on the way to the cap instead of before the drive
+    together(2),
+    moveBy(19, 70, 50),
+    armBy(0.22, 25),
+    waitFor(325),
+    intakeAt(0),
+    moveBy(-6, 70, 50),
+
+    skippable(waitFor(200)),
+    turnBy(-173, 70),
+    skippable(waitFor(200)),
+    intakeAt(600),
+    waitFor(700),
+    turnBy(-63, 70),
+    skippable(waitFor(200)),
+    critical(moveBy(40, 100, 50)),
+};
+
+constexpr Step blueFarPark[] = {
+    flywheelAt(440),
+    moveBy(40.2, 80, 50),
+    intakeAt(600),
+    waitFor(250),
+    intakeAt(0),
+    moveBy(-0.5, 100, 50),
+
+    skippable(waitFor(200)),
+    pivotBy(224, 50, 10),
+    intakeAt(600),
+    waitFor(325),
+    intakeAt(0),
+    flywheelTarget(390),
+    waitFor(2000),
+    intakeAt(600),
+    waitFor(1000),
+
+    pivotBy(16, 50, 10),
+    critical(moveBy(41, 100, 50)),
+};
+
+#define ROUTINE(name, steps, alliance)                                         \
+  { name, steps, sizeof(steps) / sizeof(Step), alliance }
+
+// The far routines take different paths on each alliance, so those tables
+// are written one per alliance and never mirrored.
+constexpr Routine routines[] = {
+    ROUTINE("FrontPark", frontPark, redAlliance),
+    ROUTINE("FrontNP", frontNP, redAlliance),
+    ROUTINE("RedFarNP", redFarNP, redAlliance),
+    ROUTINE("BlueFarNP", blueFarNP, blueAlliance),
+    ROUTINE("RedFarPark", redFarPark, redAlliance),
+    ROUTINE("BlueFarPark", blueFarPark, blueAlliance),
+};
+
+constexpr int routineCount = sizeof(routines) / sizeof(Routine);
+
+CHECK_ROUTINE(frontPark);
+CHECK_ROUTINE(frontNP);
+CHECK_ROUTINE(redFarNP);
+CHECK_ROUTINE(blueFarNP);
+CHECK_ROUTINE(redFarPark);
+CHECK_ROUTINE(blueFarPark);
+
+#endif
@@ -1,4 +1,9 @@
 #include "robot-config.h"
+#include "algorithm"
+#include "executor.h"
+#include "routinefile.h"
+#include "routines.h"
+#include "warmup.h"
 /*---------------------------------------------------------------------------
 
        WalshBots 9791 unified competition template
@@ -45,15 +50,17 @@ typedef struct _button {
 // Button array definitions for each software button. The purpose of each button
 // data structure is defined above.  The array size can be extended, so you can
 // have as many buttons as you wish as long as it fits.
-button buttons[] = {{30, 30, 60, 60, false, 0xE00000, 0xA9A9A9, "Red"},
-                    {150, 30, 60, 60, false, 0x303030, 0xA9A9A9, "Front"},
-                    {270, 30, 60, 60, false, 0x303030, 0xA9A9A9, "Park"},
+// Red, Front and Park start pressed so there is always a routine to run.
+button buttons[] = {{30, 30, 60, 60, true, 0xE00000, 0xA9A9A9, "Red"},
+                    {150, 30, 60, 60, true, 0x303030, 0xA9A9A9, "Front"},
+                    {270, 30, 60, 60, true, 0x303030, 0xA9A9A9, "Park"},
                     {30, 150, 60, 60, false, 0x404040, 0xA9A9A9, "Blue"},
                     {150, 150, 60, 60, false, 0x404040, 0xA9A9A9, "Back"},
                     {270, 150, 60, 60, false, 0x404040, 0xA9A9A9, "NP"}};
 
 // forward ref
 void displayButtonControls(int index, bool pressed);
+bool prepareRoutine();
 
 /*-----------------------------------------------------------------------------*/
 /** @brief      Check if touch is inside button */
@@ -120,6 +127,9 @@ void userTouchCallbackReleased() {
     // save as auton selection
     autonomousSelection = index;
 
+    // work out the new routine's timings now rather than in the match
+    prepareRoutine();
+
     displayButtonControls(index, false);
   }
 }
@@ -161,6 +171,447 @@ void displayButtonControls(int index, bool pressed) {
   }
 }
 
+/*---------------------------------------------------------------------------*/
+/*                                  Motion                                   */
+/*                                                                           */
+/*  The trapezoid moves and turns from the routine projects. The gains live  */
+/*  in one struct instead of inside each speed function, and every loop      */
+/*  gives up at the deadline the executor hands it, or as soon as what it    */
+/*  drives has stopped turning.                                              */
+/*---------------------------------------------------------------------------*/
+
+struct MotionGains {
+  double acceleration;     // pct gained per wheel rev from the start
+  double deceleration;     // pct lost per wheel rev before the end
+  double turnMinimum;      // pct
+  double turnAcceleration; // pct per wheel rev
+  double turnDeceleration; // pct per wheel rev
+};
+
+MotionGains gains = {30.0, 30.0, 20.0, 100.0, 50.0};
+
+const double wheelCircumference = 3.14159 * 4;
+const double driveRpm = 200.0; // drive motors at 100 pct
+const uint32_t settleTime = 50;
+
+// How long a motion loop gives up the Brain for on each pass
+const uint32_t motionSlice = 5;
+
+struct StallLimits {
+  double rpm;       // slower than this counts as not turning
+  uint32_t ms;      // for this long in a row
+  uint32_t graceMs; // not checked while it gets going
+};
+
+StallLimits driveStall = {5.0, 250, 300};
+StallLimits armStall = {2.0, 250, 200};
+
+// How far the robot backs away from whatever stopped a drive
+const double backOffDistance = 2.0;
+const uint32_t backOffTime = 600;
+
+// Times how long a mechanism that is being driven has not been turning
+class StallWatch {
+public:
+  StallWatch(const StallLimits &limits)
+      : limits(limits), startedAt(vex::timer::system()),
+        turningAt(startedAt) {}
+
+  // rpm is the fastest any of the mechanism's motors is turning
+  bool stalled(double rpm) {
+    uint32_t now = vex::timer::system();
+    if (now - startedAt < limits.graceMs || std::abs(rpm) >= limits.rpm) {
+      turningAt = now;
+      return false;
+    }
+    return now - turningAt >= limits.ms;
+  }
+
+private:
+  const StallLimits &limits;
+  uint32_t startedAt;
+  uint32_t turningAt;
+};
+
+double fastest(vex::motor *motors[], int count) {
+  double rpm = 0;
+  for (int i = 0; i < count; i++)
+    rpm = std::max(rpm, std::abs(motors[i]->velocity(vex::velocityUnits::rpm)));
+  return rpm;
+}
+
+// False once the deadline has passed, or the group the step is in has joined
+bool beforeDeadline(uint32_t deadlineMs) {
+  return (int32_t)(deadlineMs - vex::timer::system()) > 0 && !groupJoined();
+}
+
+// Sets one motor's speed along the profile, returns false and brakes it once
+// it has covered revs
+bool profileMotor(vex::motor &motor, double start, double revs,
+                  double direction, double maxVelocity, double minimum,
+                  double acceleration, double deceleration) {
+  double travelled =
+      direction * (motor.rotation(vex::rotationUnits::rev) - start);
+  if (travelled >= revs) {
+    motor.stop(vex::brakeType::brake);
+    return false;
+  }
+
+  double speed =
+      std::min(maxVelocity,
+               std::min(acceleration * std::abs(travelled) + minimum,
+                        deceleration * std::abs(revs - travelled) + minimum));
+  motor.setVelocity(direction * speed, vex::velocityUnits::pct);
+  return true;
+}
+
+// Drives distanceIn straight
+StepOutcome forward(double distanceIn, double maxVelocity, double minimum,
+                    uint32_t deadlineMs) {
+  if (distanceIn == 0)
+    return stepDone;
+
+  double direction = distanceIn > 0 ? 1.0 : -1.0;
+  double revs = std::abs(distanceIn) / wheelCircumference;
+
+  vex::motor *drive[4] = {&lf, &lb, &rf, &rb};
+  double start[4];
+  for (int i = 0; i < 4; i++) {
+    drive[i]->spin(vex::directionType::fwd, direction * minimum,
+                   vex::velocityUnits::pct);
+    start[i] = drive[i]->rotation(vex::rotationUnits::rev);
+  }
+
+  StallWatch watch(driveStall);
+  bool moving = true;
+  while (moving && beforeDeadline(deadlineMs)) {
+    moving = false;
+    for (int i = 0; i < 4; i++)
+      moving |= profileMotor(*drive[i], start[i], revs, direction, maxVelocity,
+                             minimum, gains.acceleration, gains.deceleration);
+    if (moving && watch.stalled(fastest(drive, 4)))
+      return stepStalled;
+    vex::task::sleep(motionSlice);
+  }
+  return moving ? stepCut : stepDone;
+}
+
+// Turns in place, positive degrees turn right
+StepOutcome turn(double degrees, double maxVelocity, uint32_t deadlineMs) {
+  double left = degrees > 0 ? 1.0 : -1.0;
+  double revs = std::abs(degrees) / 360;
+
+  vex::motor *drive[4] = {&lf, &lb, &rf, &rb};
+  double direction[4] = {left, left, -left, -left};
+  double start[4];
+  for (int i = 0; i < 4; i++) {
+    drive[i]->spin(vex::directionType::fwd, direction[i] * gains.turnMinimum,
+                   vex::velocityUnits::pct);
+    start[i] = drive[i]->rotation(vex::rotationUnits::rev);
+  }
+
+  StallWatch watch(driveStall);
+  StepOutcome outcome = stepCut;
+  while (beforeDeadline(deadlineMs)) {
+    bool moving = false;
+    for (int i = 0; i < 4; i++)
+      moving |= profileMotor(*drive[i], start[i], revs, direction[i],
+                             maxVelocity, gains.turnMinimum,
+                             gains.turnAcceleration, gains.turnDeceleration);
+    if (!moving) {
+      outcome = stepDone;
+      break;
+    }
+    if (watch.stalled(fastest(drive, 4))) {
+      outcome = stepStalled;
+      break;
+    }
+    vex::task::sleep(motionSlice);
+  }
+
+  for (int i = 0; i < 4; i++)
+    drive[i]->stop(vex::brakeType::brake);
+  return outcome;
+}
+
+void stopH() {
+  lf.stop(vex::brakeType::hold);
+  lb.stop(vex::brakeType::hold);
+  rf.stop(vex::brakeType::hold);
+  rb.stop(vex::brakeType::hold);
+}
+
+// Moves the arm and holds it there, or lets it coast to knock a cap off
+StepOutcome armMove(double revs, double rpm, bool coast, uint32_t deadlineMs) {
+  arm.rotateFor(revs, vex::rotationUnits::rev, rpm, vex::velocityUnits::rpm,
+                false);
+  vex::task::sleep(motionSlice);
+
+  StallWatch watch(armStall);
+  StepOutcome outcome = stepDone;
+  while (arm.isSpinning()) {
+    if (!beforeDeadline(deadlineMs)) {
+      outcome = stepCut;
+      break;
+    }
+    if (watch.stalled(arm.velocity(vex::velocityUnits::rpm))) {
+      outcome = stepStalled;
+      break;
+    }
+    vex::task::sleep(motionSlice);
+  }
+
+  arm.stop(coast ? vex::brakeType::coast : vex::brakeType::hold);
+  return outcome;
+}
+
+// Sleeps in slices so a wait in a group stops when the group joins
+bool sleepFor(uint32_t ms, uint32_t deadlineMs) {
+  uint32_t wake = vex::timer::system() + ms;
+  while ((int32_t)(wake - vex::timer::system()) > 0) {
+    if (!beforeDeadline(deadlineMs))
+      return false;
+    int32_t wait = std::min((int32_t)(wake - vex::timer::system()),
+                            (int32_t)motionSlice);
+    if (wait > 0)
+      vex::task::sleep(wait);
+  }
+  return true;
+}
+
+// The encoder turn of the routine projects' turnL/turnR: waits waitMs, then
+// spins on the spot until the back left wheel has turned degrees and coasts.
+// Positive degrees turn right.
+StepOutcome pivot(double degrees, double rpm, uint32_t waitMs,
+                  uint32_t deadlineMs) {
+  sleepFor(waitMs, deadlineMs);
+  lb.resetRotation();
+  sleepFor(150, deadlineMs);
+
+  double left = degrees > 0 ? rpm : -rpm;
+  lf.spin(vex::directionType::fwd, left, vex::velocityUnits::rpm);
+  lb.spin(vex::directionType::fwd, left, vex::velocityUnits::rpm);
+  rf.spin(vex::directionType::fwd, -left, vex::velocityUnits::rpm);
+  rb.spin(vex::directionType::fwd, -left, vex::velocityUnits::rpm);
+
+  vex::motor *drive[4] = {&lf, &lb, &rf, &rb};
+  StallWatch watch(driveStall);
+  StepOutcome outcome = stepCut;
+  while (beforeDeadline(deadlineMs)) {
+    double turned = std::abs(lb.rotation(vex::rotationUnits::deg));
+    if (turned >= std::abs(degrees)) {
+      outcome = stepDone;
+      break;
+    }
+    if (watch.stalled(fastest(drive, 4))) {
+      outcome = stepStalled;
+      break;
+    }
+    vex::task::sleep(motionSlice);
+  }
+
+  for (int i = 0; i < 4; i++)
+    drive[i]->stop(vex::brakeType::coast);
+  return outcome;
+}
+
+// Steps the trapezoid through time to see how long it takes to cover revs
+uint32_t profileTime(double revs, double maxVelocity, double minimum,
+                     double acceleration, double deceleration) {
+  const uint32_t step = 5;
+  double travelled = 0;
+  uint32_t ms = 0;
+  while (travelled < revs && ms < 15000) {
+    double speed =
+        std::min(maxVelocity,
+                 std::min(acceleration * travelled + minimum,
+                          deceleration * (revs - travelled) + minimum));
+    travelled += speed / 100 * driveRpm / 60000 * step;
+    ms += step;
+  }
+  return ms;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                 Routines                                  */
+/*                                                                           */
+/*  Every routine is a step table in routines.h. The buttons pick one and    */
+/*  the executor runs it, so there is one program to build and flash.        */
+/*---------------------------------------------------------------------------*/
+
+const uint32_t autonomousBudget = 15000;
+
+// Tuned copies of the routines from the SD card, loaded in pre_auton
+RoutineFile routineFiles[routineCount];
+
+// The SD card copy of a routine if it loaded, otherwise the built in one
+const Routine &routineFor(int index) {
+  if (routineFiles[index].ready())
+    return routineFiles[index].routine();
+  return routines[index];
+}
+
+// One bit per button, in the order of buttons[]
+enum SelectorBits {
+  redBit = 1,
+  frontBit = 2,
+  parkBit = 4,
+  blueBit = 8,
+  backBit = 16,
+  noParkBit = 32
+};
+
+struct Selection {
+  int8_t routine; // index into routines, -1 if the buttons make no sense
+  Alliance alliance;
+};
+
+constexpr bool sameName(const char *a, const char *b) {
+  return *a == *b && (*a == 0 || sameName(a + 1, b + 1));
+}
+
+constexpr int routineIndex(const char *name, int i = 0) {
+  return i == routineCount                ? -1
+         : sameName(routines[i].name, name) ? i
+                                            : routineIndex(name, i + 1);
+}
+
+// Exactly one of the pair is pressed
+constexpr bool oneOf(int mask, int a, int b) {
+  return ((mask & a) != 0) != ((mask & b) != 0);
+}
+
+// An alliance, a starting tile and whether to park, one of each
+constexpr bool sensible(int mask) {
+  return oneOf(mask, redBit, blueBit) && oneOf(mask, frontBit, backBit) &&
+         oneOf(mask, parkBit, noParkBit);
+}
+
+constexpr Selection selectionFor(int mask) {
+  return !sensible(mask)
+             ? Selection{-1, redAlliance}
+             : Selection{
+                   (int8_t)routineIndex(
+                       (mask & frontBit)
+                           ? ((mask & parkBit) ? "FrontPark" : "FrontNP")
+                       : (mask & blueBit)
+                           ? ((mask & parkBit) ? "BlueFarPark" : "BlueFarNP")
+                           : ((mask & parkBit) ? "RedFarPark" : "RedFarNP")),
+                   (mask & blueBit) ? blueAlliance : redAlliance};
+}
+
+// Every combination of buttons worked out by the compiler, so picking the
+// routine is one lookup
+#define SELECT4(m)                                                             \
+  selectionFor(m), selectionFor(m + 1), selectionFor(m + 2), selectionFor(m + 3)
+#define SELECT16(m) SELECT4(m), SELECT4(m + 4), SELECT4(m + 8), SELECT4(m + 12)
+
+const int selectorMasks = 64;
+constexpr Selection selections[selectorMasks] = {SELECT16(0), SELECT16(16),
+                                                 SELECT16(32), SELECT16(48)};
+
+// A combination that makes sense has to name a routine that exists
+constexpr bool selectionsComplete(int mask = 0) {
+  return mask == selectorMasks ||
+         ((!sensible(mask) || selections[mask].routine >= 0) &&
+          selectionsComplete(mask + 1));
+}
+static_assert(selectionsComplete(), "a selector combination has no routine");
+
+int selectorMask() {
+  int mask = 0;
+  for (int i = 0; i < 6; i++)
+    if (buttons[i].state)
+      mask |= 1 << i;
+  return mask;
+}
+
+const Selection &currentSelection() { return selections[selectorMask()]; }
+
+StepOutcome runStep(const Step &step, uint32_t deadlineMs) {
+  switch (step.kind) {
+  case moveStep: {
+    StepOutcome outcome =
+        forward(step.value, step.speed, step.minimum, deadlineMs);
+    stopH();
+    return outcome;
+  }
+  case turnStep:
+    return turn(step.value, step.speed, deadlineMs);
+  case pivotStep:
+    return pivot(step.value, step.speed, step.minimum, deadlineMs);
+  case flywheelStep:
+    if (step.speed == flywheelTargetOnly) {
+      fw.setVelocity(step.value, vex::velocityUnits::rpm);
+      fw2.setVelocity(step.value, vex::velocityUnits::rpm);
+    } else if (step.speed == flywheelFirstOff) {
+      fw.stop(vex::brakeType::coast);
+    } else if (step.value == 0) {
+      fw.stop(vex::brakeType::coast);
+      fw2.stop(vex::brakeType::coast);
+    } else {
+      fw.spin(vex::directionType::fwd, step.value, vex::velocityUnits::rpm);
+      fw2.spin(vex::directionType::fwd, step.value, vex::velocityUnits::rpm);
+    }
+    return stepDone;
+  case intakeStep:
+    if (step.value == 0)
+      in.stop();
+    else
+      in.spin(vex::directionType::fwd, step.value, vex::velocityUnits::rpm);
+    return stepDone;
+  case armStep:
+    return armMove(step.value, step.speed, step.flags & coastStep, deadlineMs);
+  case waitStep:
+    return sleepFor(step.value, deadlineMs) ? stepDone : stepCut;
+  }
+  return stepDone;
+}
+
+uint32_t estimateStep(const Step &step) {
+  switch (step.kind) {
+  case moveStep:
+    return profileTime(std::abs(step.value) / wheelCircumference, step.speed,
+                       step.minimum, gains.acceleration, gains.deceleration) +
+           settleTime;
+  case turnStep:
+    return profileTime(std::abs(step.value) / 360, step.speed,
+                       gains.turnMinimum, gains.turnAcceleration,
+                       gains.turnDeceleration) +
+           settleTime;
+  case pivotStep:
+    // rpm of the back left wheel, plus the wait and the 150 ms to reset it
+    return step.speed == 0 ? 0
+                           : std::abs(step.value) / 360 / step.speed * 60000 +
+                                 step.minimum + 150;
+  case armStep:
+    return step.speed == 0 ? 0 : std::abs(step.value) / step.speed * 60000;
+  case waitStep:
+    return step.value;
+  }
+  return 0;
+}
+
+// After a drive that ran into something, back away from it so the next step
+// starts clear. A stuck turn just stops, and a stuck arm holds where it got.
+void recoverStep(const Step &step, uint32_t deadlineMs) {
+  if (step.kind == armStep) {
+    arm.stop(vex::brakeType::hold);
+    return;
+  }
+
+  uint32_t deadline = vex::timer::system() + backOffTime;
+  if ((int32_t)(deadlineMs - deadline) < 0)
+    deadline = deadlineMs;
+
+  if (step.kind == moveStep)
+    forward(step.value > 0 ? -backOffDistance : backOffDistance, 40, 30,
+            deadline);
+  stopH();
+}
+
+Executor executor(runStep, estimateStep, recoverStep);
+
 /*---------------------------------------------------------------------------*/
 /*                          Pre-Autonomous Functions                         */
 /*                                                                           */
@@ -171,9 +622,77 @@ void displayButtonControls(int index, bool pressed) {
 /*  not every time that the robot is disabled.                               */
 /*---------------------------------------------------------------------------*/
 
+WarmUp warmUp;
+
+bool zeroEncoders() {
+  lf.resetRotation();
+  lb.resetRotation();
+  rf.resetRotation();
+  rb.resetRotation();
+  arm.resetRotation();
+  return true;
+}
+
+// Stopping modes the routines expect, so the first command needs no setup
+bool setStoppingModes() {
+  fw.setStopping(vex::brakeType::coast);
+  fw2.setStopping(vex::brakeType::coast);
+  arm.setStopping(vex::brakeType::hold);
+  in.setStopping(vex::brakeType::brake);
+  return true;
+}
+
+// Warm-up stage name, changed to the file and the reason if one is refused
+char routineFileStage[48] = "sd files";
+
+// Loads <name>.rtn for any routine that has one. A file that is there but
+// fails its checks is reported, and the built in routine runs instead.
+bool loadRoutineFiles() {
+  bool ok = true;
+  for (int i = 0; i < routineCount; i++) {
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%s.rtn", routines[i].name);
+    if (!Brain.SDcard.isInserted() || !Brain.SDcard.exists(fileName))
+      continue;
+    if (!routineFiles[i].load(Brain, fileName, routines[i].name) && ok) {
+      snprintf(routineFileStage, sizeof(routineFileStage), "%s %s", fileName,
+               routineFiles[i].why());
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// Step durations and the time to hold back for parking, worked out now
+bool prepareRoutine() {
+  const Selection &selection = currentSelection();
+  if (selection.routine < 0)
+    return false;
+  return executor.prepare(routineFor(selection.routine), selection.alliance);
+}
+
 void pre_auton(void) {
   // All activities that occur before the competition starts
-  // Example: clearing encoders, setting servo positions, ...
+  warmUp.begin(Brain);
+
+  warmUp.checkMotor("lf", lf);
+  warmUp.checkMotor("lb", lb);
+  warmUp.checkMotor("rf", rf);
+  warmUp.checkMotor("rb", rb);
+  warmUp.checkMotor("fw", fw);
+  warmUp.checkMotor("fw2", fw2);
+  warmUp.checkMotor("in", in);
+  warmUp.checkMotor("arm", arm);
+
+  // the robot sits still on the tile now, it will not during autonomous
+  warmUp.calibrateGyro("Gyro", Gyro, 3000);
+
+  warmUp.stage("encoders", zeroEncoders);
+  warmUp.stage("stopping", setStoppingModes);
+  warmUp.stage(routineFileStage, loadRoutineFiles);
+  warmUp.stage("routine", prepareRoutine);
+
+  warmUp.finish();
 }
 
 /*---------------------------------------------------------------------------*/
@@ -188,13 +707,18 @@ void pre_auton(void) {
 
 void autonomous(void) {
 
-  /* initialize capabilities from buttons */
-  bool allianceBlue = buttons[0].state;
-  bool startTileFar = buttons[1].state;
-  bool doPark = buttons[2].state;
-  bool shootPreload = buttons[3].state;
+  // the robot stays put rather than guess what was meant
+  const Selection &selection = currentSelection();
+  if (selection.routine < 0)
+    return;
 
-  
+  // normally done when the buttons change, this only catches a failed prepare
+  const Routine &selected = routineFor(selection.routine);
+  if (!executor.prepared(selected, selection.alliance))
+    executor.prepare(selected, selection.alliance);
+
+  executor.run(autonomousBudget);
+  executor.save(Brain, "auton.csv");
 }
 
 /*----------------------------------------------------------------------------*/
@@ -224,26 +748,26 @@ void usercontrol(void) {
       driveReverseDirection = false;
     }
     if (!driveReverseDirection) {
-      Leftfront.spin(vex::directionType::fwd, Controller1.Axis3.value(),
-                     vex::velocityUnits::pct); //(Axis3+Axis4)/2
-      Leftback.spin(vex::directionType::fwd, Controller1.Axis3.value(),
-                    vex::velocityUnits::pct); //(Axis3+Axis4)/2
-      Rightfront.spin(vex::directionType::fwd, Controller1.Axis2.value(),
-                      vex::velocityUnits::pct); //(Axis3-Axis4)/2
-      Rightback.spin(vex::directionType::fwd, Controller1.Axis2.value(),
-                     vex::velocityUnits::pct); //(Axis3-Axis4)/2
+      lf.spin(vex::directionType::fwd, Controller1.Axis3.value(),
+              vex::velocityUnits::pct); //(Axis3+Axis4)/2
+      lb.spin(vex::directionType::fwd, Controller1.Axis3.value(),
+              vex::velocityUnits::pct); //(Axis3+Axis4)/2
+      rf.spin(vex::directionType::fwd, Controller1.Axis2.value(),
+              vex::velocityUnits::pct); //(Axis3-Axis4)/2
+      rb.spin(vex::directionType::fwd, Controller1.Axis2.value(),
+              vex::velocityUnits::pct); //(Axis3-Axis4)/2
     } else {
       // controls will be switched so now left is right side and vice versa.
       // motors spin opposite direction.
       // control sticks are swapped
-      Leftfront.spin(vex::directionType::rev, Controller1.Axis2.value(),
-                     vex::velocityUnits::pct); //(Axis3+Axis4)/2
-      Leftback.spin(vex::directionType::rev, Controller1.Axis2.value(),
-                    vex::velocityUnits::pct); //(Axis3+Axis4)/2
-      Rightfront.spin(vex::directionType::rev, Controller1.Axis3.value(),
-                      vex::velocityUnits::pct); //(Axis3-Axis4)/2
-      Rightback.spin(vex::directionType::rev, Controller1.Axis3.value(),
-                     vex::velocityUnits::pct); //(Axis3-Axis4)/2
+      lf.spin(vex::directionType::rev, Controller1.Axis2.value(),
+              vex::velocityUnits::pct); //(Axis3+Axis4)/2
+      lb.spin(vex::directionType::rev, Controller1.Axis2.value(),
+              vex::velocityUnits::pct); //(Axis3+Axis4)/2
+      rf.spin(vex::directionType::rev, Controller1.Axis3.value(),
+              vex::velocityUnits::pct); //(Axis3-Axis4)/2
+      rb.spin(vex::directionType::rev, Controller1.Axis3.value(),
+              vex::velocityUnits::pct); //(Axis3-Axis4)/2
     }
     vex::task::sleep(20);
   }
@@ -284,6 +808,29 @@ int main() {
 
     Brain.Screen.setPenColor(vex::color(0xc11f27));
     Brain.Screen.printAt(0, 135, "  50505X Aviators  ");
+
+    // the routine the buttons pick, so a wrong combination is seen in time
+    const Selection &selection = currentSelection();
+    char picked[24];
+    if (selection.routine < 0)
+      snprintf(picked, sizeof(picked), "%-20s", "INVALID SELECTION");
+    else
+      snprintf(picked, sizeof(picked), "%-11s %-8s",
+               routines[selection.routine].name,
+               selection.alliance == blueAlliance ? "blue" : "red");
+    Brain.Screen.setFont(fontType::mono20);
+    Brain.Screen.setPenColor(selection.routine < 0 ? vex::color(0xc11f27)
+                                                   : vex::color(0x00c000));
+    Brain.Screen.printAt(10, 235, picked);
+
+    // warm-up verdict in the corner, "ready" or what to check
+    char status[16];
+    snprintf(status, sizeof(status), "%-10s", warmUp.status());
+    Brain.Screen.setFont(fontType::mono20);
+    Brain.Screen.setPenColor(warmUp.ready() ? vex::color(0x00c000)
+                                            : vex::color(0xc11f27));
+    Brain.Screen.printAt(370, 235, status);
+    Brain.Screen.setFont(fontType::mono40);
     this_thread::sleep_for(10);
   }
 }
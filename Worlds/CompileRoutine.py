@@ -0,0 +1,185 @@
+import re
+import struct
+import sys
+
+# Turns a routine written as text into the .rtn file AutonSelector loads from
+# the SD card (see AutonSelector/include/routinefile.h for the layout).
+#
+#   python3 CompileRoutine.py FrontPark.txt FrontPark.rtn
+#   python3 CompileRoutine.py AutonSelector/include/routines.h FrontPark.rtn frontPark
+#
+# The text is the same builder calls as routines.h, one step per line:
+#
+#   alliance red
+#   flywheelAt(525)
+#   skippable(waitFor(200))
+#   redOnly(critical(moveBy(42.3, 100, 60)))
+#   together(2, joinFirst)
+#
+# Given a table name as well, the table is taken straight out of a header.
+# The Brain runs the full range and timing checks when it loads the file.
+
+version = 1
+
+# builder: (kind, defaults for value, speed, minimum)
+builders = {
+    "moveBy": (0, [None, 100, 60]),
+    "turnBy": (1, [None, None]),
+    "pivotBy": (2, [None, None, None]),
+    "flywheelAt": (3, [None]),
+    "flywheelTarget": (3, [None]),
+    "flywheelFirstCoasts": (3, []),
+    "intakeAt": (4, [None]),
+    "armBy": (5, [None, None]),
+    "waitFor": (6, [None]),
+    "together": (7, [None, 0]),
+}
+
+joins = {"joinAll": 0, "joinAny": 1, "joinFirst": 2}
+
+flags = {
+    "skippable": 1,
+    "critical": 2,
+    "coasting": 4,
+    "redOnly": 8,
+    "blueOnly": 16,
+}
+
+alliances = {"red": 0, "blue": 1, "redAlliance": 0, "blueAlliance": 1}
+
+
+class RoutineError(Exception):
+    pass
+
+
+def splitArguments(text):
+    arguments = []
+    depth = 0
+    current = ""
+    for c in text:
+        if c == "," and depth == 0:
+            arguments.append(current.strip())
+            current = ""
+            continue
+        if c == "(":
+            depth += 1
+        elif c == ")":
+            depth -= 1
+        current += c
+    if current.strip() != "":
+        arguments.append(current.strip())
+    return arguments
+
+
+def parseStep(text):
+    match = re.match(r"^(\w+)\((.*)\)$", text.strip())
+    if match is None:
+        raise RoutineError("not a step: " + text)
+    name = match.group(1)
+    arguments = splitArguments(match.group(2))
+
+    if name in flags:
+        if len(arguments) != 1:
+            raise RoutineError(name + " takes one step")
+        step = parseStep(arguments[0])
+        step["flags"] |= flags[name]
+        return step
+
+    if name == "expecting":
+        if len(arguments) != 2:
+            raise RoutineError("expecting takes a step and a time in ms")
+        step = parseStep(arguments[0])
+        step["expectedMs"] = int(float(arguments[1]))
+        return step
+
+    if name not in builders:
+        raise RoutineError("unknown step: " + name)
+    kind, defaults = builders[name]
+    if len(arguments) > len(defaults):
+        raise RoutineError(name + " takes at most " + str(len(defaults)) +
+                           " numbers")
+    numbers = [joins[a] if a in joins else float(a.rstrip("f"))
+               for a in arguments]
+    numbers += defaults[len(numbers):]
+    if None in numbers:
+        raise RoutineError(name + " is missing a number")
+
+    step = {"kind": kind, "flags": 0, "expectedMs": 0,
+            "value": numbers[0] if numbers else 0, "speed": 0, "minimum": 0}
+    if name == "flywheelTarget":
+        step["speed"] = 1
+    elif name == "flywheelFirstCoasts":
+        step["speed"] = 2
+    elif name in ("moveBy", "turnBy", "pivotBy", "armBy", "together"):
+        step["speed"] = numbers[1]
+    if name in ("moveBy", "pivotBy"):
+        step["minimum"] = numbers[2]
+    return step
+
+
+def readText(lines):
+    alliance = 0
+    steps = []
+    for number, line in enumerate(lines, 1):
+        line = line.split("//")[0].split("#")[0].strip().rstrip(",")
+        if line == "":
+            continue
+        words = line.split()
+        if words[0] == "alliance":
+            if len(words) != 2 or words[1] not in alliances:
+                raise RoutineError("line " + str(number) +
+                                   ": alliance is red or blue")
+            alliance = alliances[words[1]]
+            continue
+        try:
+            steps.append(parseStep(line))
+        except (RoutineError, ValueError) as error:
+            raise RoutineError("line " + str(number) + ": " + str(error))
+    return alliance, steps
+
+
+# The lines of one table in a header, with the alliance it was written for
+def readTable(text, table):
+    match = re.search(r"Step\s+" + table + r"\[\]\s*=\s*\{(.*?)\};", text,
+                      re.S)
+    if match is None:
+        raise RoutineError("no table called " + table)
+    written = re.search(r"ROUTINE\(\s*\"\w+\"\s*,\s*" + table +
+                        r"\s*,\s*(\w+)\s*\)", text)
+    alliance = "red" if written is None else written.group(1)
+    return ["alliance " + alliance] + match.group(1).split("\n")
+
+
+def pack(alliance, steps):
+    data = b"RTNE" + struct.pack("<BBH", version, alliance, len(steps))
+    for step in steps:
+        for field in ("speed", "minimum"):
+            if step[field] != int(step[field]) or not 0 <= step[field] < 65536:
+                raise RoutineError(field + " has to be a whole number: " +
+                                   str(step[field]))
+        data += struct.pack("<BBHiHH", step["kind"], step["flags"],
+                            step["expectedMs"], int(round(step["value"] * 1000)),
+                            int(step["speed"]), int(step["minimum"]))
+    return data
+
+
+if __name__ == "__main__":
+    if len(sys.argv) not in (3, 4):
+        print("usage: CompileRoutine.py source output.rtn [table]")
+        sys.exit(2)
+
+    try:
+        with open(sys.argv[1]) as source:
+            text = source.read()
+        lines = text.split("\n")
+        if len(sys.argv) == 4:
+            lines = readTable(text, sys.argv[3])
+        alliance, steps = readText(lines)
+        data = pack(alliance, steps)
+    except RoutineError as error:
+        print(sys.argv[1] + ": " + str(error))
+        sys.exit(1)
+
+    with open(sys.argv[2], "wb") as output:
+        output.write(data)
+    print(str(len(steps)) + " steps, " + str(len(data)) + " bytes")
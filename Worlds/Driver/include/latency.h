@@ -0,0 +1,211 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                      Input-to-actuation latency probes                    */
+/*                                                                           */
+/*  Timestamps come from the Brain's microsecond timer. Each histogram keeps */
+/*  the most recent samples in a ring so the percentiles follow whatever is */
+/*  running right now, and an all-time maximum on the side.                  */
+/*---------------------------------------------------------------------------*/
+
+// Rolling histogram of latencies in microseconds
+class LatencyHistogram {
+public:
+  static const int bucketCount = 256;
+  static const uint32_t bucketWidthUs = 200;
+  static const int window = 1024;
+
+  LatencyHistogram() { reset(); }
+
+  void reset() {
+    for (int i = 0; i < bucketCount; i++)
+      counts[i] = 0;
+    head = 0;
+    filled = 0;
+    maxUs = 0;
+    total = 0;
+  }
+
+  void add(uint32_t us) {
+    int bucket = us / bucketWidthUs;
+    if (bucket >= bucketCount)
+      bucket = bucketCount - 1;
+
+    // once the ring is full the oldest sample falls out of the histogram
+    if (filled == window)
+      counts[recent[head]]--;
+    else
+      filled++;
+
+    recent[head] = (uint8_t)bucket;
+    counts[bucket]++;
+    head = (head + 1) % window;
+
+    total++;
+    if (us > maxUs)
+      maxUs = us;
+  }
+
+  // Upper edge of the bucket below which `fraction` of the recent samples fall
+  uint32_t percentile(double fraction) const {
+    if (filled == 0)
+      return 0;
+
+    int target = (int)(fraction * filled + 0.5);
+    if (target < 1)
+      target = 1;
+
+    int seen = 0;
+    for (int i = 0; i < bucketCount; i++) {
+      seen += counts[i];
+      if (seen >= target)
+        return (i + 1) * bucketWidthUs;
+    }
+    return bucketCount * bucketWidthUs;
+  }
+
+  uint32_t max() const { return maxUs; }
+  uint32_t samples() const { return total; }
+  int recentSamples() const { return filled; }
+  uint16_t bucket(int index) const { return counts[index]; }
+
+private:
+  uint16_t counts[bucketCount];
+  uint8_t recent[window];
+  int head;
+  int filled;
+  uint32_t maxUs;
+  uint32_t total;
+};
+
+// Follows one pass from the controller sticks to the drive motors.
+//
+//  stickChanged() - called from the controller axis changed event
+//  sampled()      - called right after the drive loop reads the sticks
+//  commanded()    - called right after the last drive motor command
+//
+// changeToCommand is what the driver feels, sampleToCommand is the time spent
+// inside the loop, and commandPeriod is how often the motors get a new command.
+class LatencyProbe {
+public:
+  LatencyHistogram changeToCommand;
+  LatencyHistogram sampleToCommand;
+  LatencyHistogram commandPeriod;
+
+  LatencyProbe() : changedAt(0), sampledAt(0), commandedAt(0), changed(false) {}
+
+  static uint64_t now() { return vex::timer::systemHighResolution(); }
+
+  void stickChanged() {
+    // keep the earliest change until the loop gets around to acting on it
+    if (changedAt == 0)
+      changedAt = now();
+  }
+
+  void sampled(bool stickMoved) {
+    sampledAt = now();
+    changed = stickMoved;
+  }
+
+  void commanded() {
+    uint64_t t = now();
+
+    if (commandedAt != 0)
+      commandPeriod.add((uint32_t)(t - commandedAt));
+    commandedAt = t;
+
+    if (!changed) {
+      // the stick moved and came back between two reads, nothing to time
+      if (changedAt != 0 && changedAt <= sampledAt)
+        changedAt = 0;
+      return;
+    }
+
+    sampleToCommand.add((uint32_t)(t - sampledAt));
+
+    uint64_t pending = changedAt;
+    if (pending != 0 && pending <= sampledAt) {
+      changeToCommand.add((uint32_t)(t - pending));
+      changedAt = 0;
+    }
+  }
+
+  void reset() {
+    changeToCommand.reset();
+    sampleToCommand.reset();
+    commandPeriod.reset();
+    changedAt = 0;
+    commandedAt = 0;
+  }
+
+  // Draw p50/p99/max in milliseconds starting at screen row y
+  void print(vex::brain &brain, int y) const {
+    printRow(brain, y, "stick->cmd", changeToCommand);
+    printRow(brain, y + 20, "read->cmd ", sampleToCommand);
+    printRow(brain, y + 40, "cmd period", commandPeriod);
+  }
+
+  // Write a summary and the raw buckets as csv, returns bytes written
+  int32_t save(vex::brain &brain, const char *name) const {
+    static char text[8192];
+    int length = snprintf(text, sizeof(text),
+                          "histogram,samples,p50_us,p99_us,max_us\n");
+    length += summaryLine(text + length, sizeof(text) - length,
+                          "stick_to_cmd", changeToCommand);
+    length += summaryLine(text + length, sizeof(text) - length, "read_to_cmd",
+                          sampleToCommand);
+    length += summaryLine(text + length, sizeof(text) - length, "cmd_period",
+                          commandPeriod);
+
+    length += snprintf(text + length, sizeof(text) - length,
+                       "\nbucket_us,stick_to_cmd,read_to_cmd,cmd_period\n");
+    for (int i = 0; i < LatencyHistogram::bucketCount; i++) {
+      if (changeToCommand.bucket(i) == 0 && sampleToCommand.bucket(i) == 0 &&
+          commandPeriod.bucket(i) == 0)
+        continue;
+      if (length >= (int)sizeof(text) - 64)
+        break;
+      length += snprintf(text + length, sizeof(text) - length,
+                         "%lu,%u,%u,%u\n",
+                         (unsigned long)(i * LatencyHistogram::bucketWidthUs),
+                         changeToCommand.bucket(i), sampleToCommand.bucket(i),
+                         commandPeriod.bucket(i));
+    }
+
+    if (!brain.SDcard.isInserted())
+      return 0;
+    return brain.SDcard.savefile(name, (uint8_t *)text, length);
+  }
+
+private:
+  volatile uint64_t changedAt;
+  uint64_t sampledAt;
+  uint64_t commandedAt;
+  bool changed;
+
+  static void printRow(vex::brain &brain, int y, const char *label,
+                       const LatencyHistogram &h) {
+    char row[64];
+    snprintf(row, sizeof(row), "%s p50 %5.1f p99 %5.1f max %5.1f ms   ", label,
+             h.percentile(0.50) / 1000.0, h.percentile(0.99) / 1000.0,
+             h.max() / 1000.0);
+    brain.Screen.printAt(10, y, row);
+  }
+
+  static int summaryLine(char *out, int space, const char *label,
+                         const LatencyHistogram &h) {
+    return snprintf(out, space, "%s,%lu,%lu,%lu,%lu\n", label,
+                    (unsigned long)h.samples(),
+                    (unsigned long)h.percentile(0.50),
+                    (unsigned long)h.percentile(0.99), (unsigned long)h.max());
+  }
+};
+
+#endif
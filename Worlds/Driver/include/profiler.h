@@ -0,0 +1,193 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                                 Profiler                                  */
+/*                                                                           */
+/*  Named scopes timed with the Brain's microsecond timer. Each scope keeps  */
+/*  a call count, total and longest time, and a histogram with power of two  */
+/*  buckets (under 1us, under 2us, under 4us, ...). Times are wall time from */
+/*  entering to leaving the scope, so they include any time a higher         */
+/*  priority task had the Brain in between.                                  */
+/*                                                                           */
+/*    void forward(...) {                                                    */
+/*      PROFILE("forward");                                                  */
+/*      ...                                                                  */
+/*---------------------------------------------------------------------------*/
+
+class Profiler {
+public:
+  static const int maxScopes = 16;
+  static const int bucketCount = 20; // the last bucket holds everything longer
+
+  Profiler() : scopes(0), startedAt(vex::timer::systemHighResolution()) {}
+
+  // Returns the id for a scope name, adding it the first time
+  int scope(const char *name) {
+    for (int i = 0; i < scopes; i++)
+      if (strcmp(entries[i].name, name) == 0)
+        return (i);
+
+    if (scopes >= maxScopes)
+      return (-1);
+
+    Scope &s = entries[scopes];
+    s.name = name;
+    clear(s);
+    return (scopes++);
+  }
+
+  void add(int id, uint32_t us) {
+    if (id < 0)
+      return;
+
+    Scope &s = entries[id];
+    s.calls++;
+    s.totalUs += us;
+    if (us > s.maxUs)
+      s.maxUs = us;
+
+    int bucket = 0;
+    while (bucket < bucketCount - 1 && (1UL << bucket) <= us)
+      bucket++;
+    s.buckets[bucket]++;
+  }
+
+  // Upper edge in us of the bucket below which `fraction` of calls fall
+  uint32_t percentile(int id, double fraction) const {
+    const Scope &s = entries[id];
+    if (s.calls == 0)
+      return 0;
+
+    uint32_t target = (uint32_t)(fraction * s.calls + 0.5);
+    if (target < 1)
+      target = 1;
+
+    uint32_t seen = 0;
+    for (int i = 0; i < bucketCount; i++) {
+      seen += s.buckets[i];
+      if (seen >= target)
+        return i == bucketCount - 1 ? s.maxUs : (1UL << i);
+    }
+    return s.maxUs;
+  }
+
+  void reset() {
+    for (int i = 0; i < scopes; i++)
+      clear(entries[i]);
+    startedAt = vex::timer::systemHighResolution();
+  }
+
+  int count() const { return scopes; }
+
+  // One line per scope from screen row y, up to rows of them: calls, mean and
+  // p99 in us, and the share of time since the last reset
+  void print(vex::brain &brain, int y, int rows) const {
+    char line[80];
+    brain.Screen.printAt(10, y, "scope            calls   mean    p99   time");
+    for (int i = 0; i < scopes && i < rows; i++) {
+      format(line, sizeof(line), i);
+      brain.Screen.printAt(10, y + 20 * (i + 1), line);
+    }
+  }
+
+  // Summary and raw buckets as csv, returns bytes written
+  int32_t save(vex::brain &brain, const char *name) const {
+    static char text[maxScopes * (bucketCount * 11 + 96) + 128];
+    int length = snprintf(text, sizeof(text),
+                          "scope,calls,total_us,mean_us,p50_us,p99_us,max_us");
+    for (int b = 0; b < bucketCount - 1; b++)
+      length += snprintf(text + length, sizeof(text) - length, ",lt_%lu_us",
+                         1UL << b);
+    length += snprintf(text + length, sizeof(text) - length, ",longer\n");
+
+    for (int i = 0; i < scopes; i++) {
+      const Scope &s = entries[i];
+      length += snprintf(
+          text + length, sizeof(text) - length, "%s,%lu,%llu,%lu,%lu,%lu,%lu",
+          s.name, (unsigned long)s.calls, (unsigned long long)s.totalUs,
+          (unsigned long)mean(s), (unsigned long)percentile(i, 0.50),
+          (unsigned long)percentile(i, 0.99), (unsigned long)s.maxUs);
+      for (int b = 0; b < bucketCount; b++)
+        length += snprintf(text + length, sizeof(text) - length, ",%lu",
+                           (unsigned long)s.buckets[b]);
+      length += snprintf(text + length, sizeof(text) - length, "\n");
+    }
+
+    if (!brain.SDcard.isInserted())
+      return 0;
+    return brain.SDcard.savefile(name, (uint8_t *)text, length);
+  }
+
+private:
+  struct Scope {
+    const char *name;
+    uint32_t calls;
+    uint64_t totalUs;
+    uint32_t maxUs;
+    uint32_t buckets[bucketCount];
+  };
+
+  Scope entries[maxScopes];
+  int scopes;
+  uint64_t startedAt;
+
+  static void clear(Scope &s) {
+    s.calls = 0;
+    s.totalUs = 0;
+    s.maxUs = 0;
+    for (int b = 0; b < bucketCount; b++)
+      s.buckets[b] = 0;
+  }
+
+  static uint32_t mean(const Scope &s) {
+    return s.calls == 0 ? 0 : (uint32_t)(s.totalUs / s.calls);
+  }
+
+  void format(char *line, int space, int id) const {
+    const Scope &s = entries[id];
+    uint64_t elapsed = vex::timer::systemHighResolution() - startedAt;
+    double share = elapsed == 0 ? 0 : 100.0 * s.totalUs / elapsed;
+    snprintf(line, space, "%-16s %6lu %6lu %6lu %5.1f%%   ", s.name,
+             (unsigned long)s.calls, (unsigned long)mean(s),
+             (unsigned long)percentile(id, 0.99), share);
+  }
+};
+
+Profiler profiler;
+
+// Times from here to the end of the enclosing block, or to stop()
+class ProfileScope {
+public:
+  explicit ProfileScope(int id)
+      : id(id), start(vex::timer::systemHighResolution()), running(true) {}
+  ~ProfileScope() { stop(); }
+
+  void stop() {
+    if (!running)
+      return;
+    running = false;
+    profiler.add(id, (uint32_t)(vex::timer::systemHighResolution() - start));
+  }
+
+private:
+  int id;
+  uint64_t start;
+  bool running;
+};
+
+#define PROFILE_JOIN(a, b) a##b
+#define PROFILE_NAME(a, b) PROFILE_JOIN(a, b)
+#define PROFILE(name)                                                          \
+  static int PROFILE_NAME(profileId, __LINE__) = profiler.scope(name);         \
+  ProfileScope PROFILE_NAME(profileScope, __LINE__)(                           \
+      PROFILE_NAME(profileId, __LINE__))
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                        Recorded driver routes                             */
+/*                                                                           */
+/*  A recording is a fixed rate list of frames, each one holding how far     */
+/*  each side of the drive moved during the frame plus what the drive and    */
+/*  mechanisms were being told to do. On the SD card it is stored as         */
+/*                                                                           */
+/*    "RPLY" | version u8 | period ms u8 | frame count u16 | frames ...       */
+/*                                                                           */
+/*  with every field little endian and each frame packed into 10 bytes.      */
+/*---------------------------------------------------------------------------*/
+
+struct RecordedFrame {
+  int16_t leftDelta;  // left side travel this frame, tenths of a degree
+  int16_t rightDelta; // right side travel this frame, tenths of a degree
+  int8_t leftCommand; // drive commands in percent
+  int8_t rightCommand;
+  int8_t intake;     // intake velocity in tens of rpm
+  int8_t arm;        // arm velocity in rpm
+  int16_t flywheel;  // flywheel velocity in rpm
+};
+
+class Recording {
+public:
+  static const uint8_t version = 1;
+  static const int headerSize = 8;
+  static const int frameSize = 10;
+  // one minute at the default rate, enough for a full Skills run
+  static const int maxFrames = 3000;
+
+  Recording() : frames(0), period(20) {}
+
+  void clear(uint8_t periodMs) {
+    frames = 0;
+    period = periodMs;
+  }
+
+  int count() const { return frames; }
+  uint8_t periodMs() const { return period; }
+  bool full() const { return frames >= maxFrames; }
+
+  bool add(const RecordedFrame &frame) {
+    if (full())
+      return false;
+
+    uint8_t *p = data + headerSize + frames * frameSize;
+    put16(p, frame.leftDelta);
+    put16(p + 2, frame.rightDelta);
+    p[4] = (uint8_t)frame.leftCommand;
+    p[5] = (uint8_t)frame.rightCommand;
+    p[6] = (uint8_t)frame.intake;
+    p[7] = (uint8_t)frame.arm;
+    put16(p + 8, frame.flywheel);
+    frames++;
+    return true;
+  }
+
+  RecordedFrame frame(int index) const {
+    const uint8_t *p = data + headerSize + index * frameSize;
+    RecordedFrame frame;
+    frame.leftDelta = get16(p);
+    frame.rightDelta = get16(p + 2);
+    frame.leftCommand = (int8_t)p[4];
+    frame.rightCommand = (int8_t)p[5];
+    frame.intake = (int8_t)p[6];
+    frame.arm = (int8_t)p[7];
+    frame.flywheel = get16(p + 8);
+    return frame;
+  }
+
+  // Returns the number of bytes written, 0 without an SD card
+  int32_t save(vex::brain &brain, const char *name) {
+    if (!brain.SDcard.isInserted())
+      return 0;
+
+    memcpy(data, "RPLY", 4);
+    data[4] = version;
+    data[5] = period;
+    put16(data + 6, (int16_t)frames);
+    return brain.SDcard.savefile(name, data, headerSize + frames * frameSize);
+  }
+
+  // Loads and checks a saved recording, leaves this one empty on failure
+  bool load(vex::brain &brain, const char *name) {
+    frames = 0;
+    if (!brain.SDcard.isInserted())
+      return false;
+
+    int32_t length = brain.SDcard.loadfile(name, data, sizeof(data));
+    if (length < headerSize || memcmp(data, "RPLY", 4) != 0 ||
+        data[4] != version || data[5] == 0)
+      return false;
+
+    int count = (uint16_t)get16(data + 6);
+    if (count > maxFrames || length < headerSize + count * frameSize)
+      return false;
+
+    period = data[5];
+    frames = count;
+    return true;
+  }
+
+private:
+  uint8_t data[headerSize + maxFrames * frameSize];
+  int frames;
+  uint8_t period;
+
+  static void put16(uint8_t *p, int16_t value) {
+    p[0] = (uint8_t)(value & 0xFF);
+    p[1] = (uint8_t)((value >> 8) & 0xFF);
+  }
+
+  static int16_t get16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+  }
+};
+
+#endif
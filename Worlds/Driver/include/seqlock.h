@@ -0,0 +1,55 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                                 Seqlock                                   */
+/*                                                                           */
+/*  One task publishes a value, any number of tasks read it. The sequence is */
+/*  odd while a publish is under way, so a reader that sees it odd, or sees  */
+/*  it change while copying, copies again. Readers never block the writer    */
+/*  and always come away with a value from a single publish.                 */
+/*---------------------------------------------------------------------------*/
+
+template <typename T> class Seqlock {
+public:
+  Seqlock() : value(), sequence(0) {}
+
+  // Writer side only
+  void publish(const T &next) {
+    sequence++;
+    __sync_synchronize();
+    value = next;
+    __sync_synchronize();
+    sequence++;
+  }
+
+  T read() const {
+    T copy;
+    for (int tries = 1;; tries++) {
+      uint32_t before = sequence;
+      __sync_synchronize();
+      copy = value;
+      __sync_synchronize();
+      if ((before & 1) == 0 && before == sequence)
+        return copy;
+
+      // a lower priority writer cannot finish while we spin, so let it run
+      if (tries % 4 == 0)
+        vex::task::sleep(1);
+    }
+  }
+
+  // How many times a value has been published
+  uint32_t version() const { return sequence / 2; }
+
+private:
+  T value;
+  volatile uint32_t sequence;
+};
+
+#endif
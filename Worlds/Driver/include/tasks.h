@@ -0,0 +1,182 @@
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "profiler.h"
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                               Task Classes                                */
+/*                                                                           */
+/*  Every background job is a step function that does one pass of work and   */
+/*  returns. The runtime owns the loop: it calls the step once per period at */
+/*  the priority of the job's class and always sleeps in between, so no job  */
+/*  can hog the Brain. A job must give its own period, at least its class's  */
+/*  minimum: one with no period would loop freely, and is refused when it is */
+/*  registered. Every pass is timed by the profiler under the job's name.    */
+/*---------------------------------------------------------------------------*/
+
+enum TaskClass {
+  controlTask,   // drive and motion loops
+  sensingTask,   // device sampling that control depends on
+  mechanismTask, // flywheel, intake and arm
+  uiTask,        // Brain and controller screens
+  loggingTask,   // SD card and other slow output
+  taskClassCount
+};
+
+struct TaskClassPolicy {
+  const char *name;
+  int32_t priority;
+  uint32_t minPeriodMs; // the fastest a job in this class may run
+};
+
+// Sensing wakes first so control always works from fresh data. UI and logging
+// sit below the competition tasks and only run when everything else sleeps.
+const TaskClassPolicy taskPolicies[taskClassCount] = {
+    {"control", 12, 5},
+    {"sensing", 13, 5},
+    {"mechanism", 10, 10},
+    {"ui", 3, 50},
+    {"logging", 2, 20},
+};
+
+// How long a busy motion loop gives up the Brain for on each pass. The motors
+// only report new positions every few milliseconds, so this costs no accuracy.
+const uint32_t controlSlice = 5;
+
+inline void yieldControl() { vex::task::sleep(controlSlice); }
+
+// One pass of a job, returns false when the job is finished
+typedef bool (*TaskStep)(void);
+
+struct PeriodicTask {
+  const char *name;
+  TaskClass taskClass;
+  TaskStep step;
+  uint32_t periodMs;
+  volatile bool running;
+  uint32_t runs;
+  uint32_t late; // passes that finished after their next start time
+  volatile uint32_t lastPass; // when the last pass finished, in ms
+  int profileId;
+};
+
+const int maxPeriodicTasks = 8;
+PeriodicTask periodicTasks[maxPeriodicTasks];
+int periodicTaskCount = 0;
+
+// Calls step every periodMs until it returns false or the job is stopped
+int runPeriodic(PeriodicTask &job) {
+  uint32_t next = vex::timer::system();
+
+  job.lastPass = next;
+
+  while (job.running) {
+    ProfileScope pass(job.profileId);
+    bool more = job.step();
+    pass.stop();
+    if (!more)
+      break;
+
+    job.runs++;
+    job.lastPass = vex::timer::system();
+    next += job.periodMs;
+
+    int32_t wait = (int32_t)(next - vex::timer::system());
+    if (wait <= 0) {
+      // behind schedule, start over from now but still let others run
+      job.late++;
+      next = vex::timer::system();
+      wait = 1;
+    }
+    vex::task::sleep(wait);
+  }
+
+  job.running = false;
+  return (0);
+}
+
+// vex::task entry points take no arguments, so each slot gets its own
+template <int slot> int periodicEntry() {
+  return runPeriodic(periodicTasks[slot]);
+}
+
+int (*const periodicEntries[maxPeriodicTasks])(void) = {
+    periodicEntry<0>, periodicEntry<1>, periodicEntry<2>, periodicEntry<3>,
+    periodicEntry<4>, periodicEntry<5>, periodicEntry<6>, periodicEntry<7>};
+
+int findTask(const char *name) {
+  for (int slot = 0; slot < periodicTaskCount; slot++)
+    if (strcmp(periodicTasks[slot].name, name) == 0)
+      return (slot);
+  return (-1);
+}
+
+// Fills in a job, returns its slot or -1 if the class refuses it. A job that
+// registers again under the same name gets its old slot back.
+int registerTask(const char *name, TaskClass taskClass, TaskStep step,
+                 uint32_t periodMs) {
+  const TaskClassPolicy &policy = taskPolicies[taskClass];
+  if (step == NULL || periodMs == 0 || periodMs < policy.minPeriodMs)
+    return (-1);
+
+  int slot = findTask(name);
+  if (slot < 0) {
+    if (periodicTaskCount >= maxPeriodicTasks)
+      return (-1);
+    slot = periodicTaskCount++;
+  }
+
+  PeriodicTask &job = periodicTasks[slot];
+  job.name = name;
+  job.taskClass = taskClass;
+  job.step = step;
+  job.periodMs = periodMs;
+  job.running = true;
+  job.runs = 0;
+  job.late = 0;
+  job.lastPass = vex::timer::system();
+  job.profileId = profiler.scope(name);
+  return (slot);
+}
+
+// Starts a job in its own task at the class priority. Returns the job's slot,
+// or -1 if it was refused.
+int startTask(const char *name, TaskClass taskClass, TaskStep step,
+              uint32_t periodMs) {
+  // one copy of a job at a time
+  int running = findTask(name);
+  if (running >= 0 && periodicTasks[running].running)
+    return (-1);
+
+  int slot = registerTask(name, taskClass, step, periodMs);
+  if (slot < 0)
+    return (-1);
+
+  vex::task job(periodicEntries[slot], taskPolicies[taskClass].priority);
+  return (slot);
+}
+
+// Runs a job in the calling task, for loops that belong to a competition
+// callback and have to end with it. The competition stops those tasks without
+// telling us, so the slot is simply taken over the next time around. Returns
+// once the job finishes, or straight away with -1 if it was refused.
+int runTask(const char *name, TaskClass taskClass, TaskStep step,
+            uint32_t periodMs) {
+  int slot = registerTask(name, taskClass, step, periodMs);
+  if (slot < 0)
+    return (-1);
+
+  return runPeriodic(periodicTasks[slot]);
+}
+
+void stopTask(int slot) {
+  if (slot >= 0 && slot < periodicTaskCount)
+    periodicTasks[slot].running = false;
+}
+
+#endif
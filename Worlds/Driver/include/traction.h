@@ -0,0 +1,103 @@
+#ifndef TRACTION_H
+#define TRACTION_H
+
+#include <math.h>
+
+/*---------------------------------------------------------------------------*/
+/*                             Traction Control                              */
+/*                                                                           */
+/*  One of these per side of the drive. Every drive tick it takes what the   */
+/*  driver asked for and what the wheels are actually doing, and returns the */
+/*  command to send. All velocities are in percent.                          */
+/*                                                                           */
+/*  - speeding up is slew limited so the robot does not wheelie or tip back  */
+/*  - slowing down is slew limited too, but harder, so it still stops short  */
+/*  - the command may only lead the measured wheel speed by so much          */
+/*  - a rise in measured speed the chassis cannot produce means the wheels   */
+/*    broke loose, so the command is cut back to below the measured speed    */
+/*    and held there for a moment to let the wheels hook up again            */
+/*---------------------------------------------------------------------------*/
+
+class TractionControl {
+public:
+  double accelLimit;   // percent per second while speeding up
+  double decelLimit;   // percent per second while slowing down
+  double leadLimit;    // percent the command may run ahead of the wheels
+  double spinAccel;    // percent per second of wheel speed change that is spin
+  double spinBackoff;  // fraction of the wheel speed to drop to on spin
+  double recoveryTime; // seconds to hold the command down after spin
+
+  TractionControl()
+      : accelLimit(250), decelLimit(400), leadLimit(35), spinAccel(600),
+        spinBackoff(0.3), recoveryTime(0.15), output(0), lastMeasured(0),
+        recovering(0), spinning(false) {}
+
+  double update(double target, double measured, double dt) {
+    if (dt <= 0)
+      return output;
+
+    target = clamp(target, -100, 100);
+
+    // wheel speed growing faster than the chassis can accelerate. Wheels
+    // slowing down that fast are braking or reversing, which is not spin.
+    double wheelAccel = (measured - lastMeasured) / dt;
+    lastMeasured = measured;
+    spinning = fabs(wheelAccel) > spinAccel && sameSign(wheelAccel, measured) &&
+               fabs(measured) > fabs(output);
+    if (spinning) {
+      output = alongTarget(measured * (1 - spinBackoff), target);
+      recovering = recoveryTime;
+      return output;
+    }
+
+    if (recovering > 0) {
+      recovering -= dt;
+      // only allow the command to come down until the wheels hook up again
+      if (fabs(target) > fabs(output) && sameSign(target, output))
+        return output;
+    }
+
+    // speeding up if the target is further from zero in the same direction
+    bool speedingUp = fabs(target) > fabs(output) && sameSign(target, output);
+    double step = (speedingUp ? accelLimit : decelLimit) * dt;
+    output += clamp(target - output, -step, step);
+
+    // never ask for much more than the wheels are doing
+    if (speedingUp)
+      output = alongTarget(
+          clamp(output, measured - leadLimit, measured + leadLimit), target);
+
+    return output;
+  }
+
+  void reset() {
+    output = 0;
+    lastMeasured = 0;
+    recovering = 0;
+    spinning = false;
+  }
+
+  double command() const { return output; }
+  bool slipping() const { return spinning || recovering > 0; }
+
+private:
+  double output;
+  double lastMeasured;
+  double recovering;
+  bool spinning;
+
+  static double clamp(double value, double low, double high) {
+    return value < low ? low : (value > high ? high : value);
+  }
+
+  static bool sameSign(double a, double b) {
+    return b == 0 || (a > 0) == (b > 0);
+  }
+
+  // A limit never turns the command against the driver, only down to zero
+  static double alongTarget(double command, double target) {
+    return sameSign(command, target) ? command : 0;
+  }
+};
+
+#endif
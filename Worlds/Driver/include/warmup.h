@@ -0,0 +1,125 @@
+#ifndef WARMUP_H
+#define WARMUP_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                                 Warm-Up                                   */
+/*                                                                           */
+/*  Everything that can be done before the match starts is done here from    */
+/*  pre_auton, one stage at a time with a line on the Brain screen for each: */
+/*  devices that do not answer, gyro calibration, zeroed encoders and any    */
+/*  routine data worked out ahead of time. The last line says READY, or what */
+/*  to check before the robot is put on the field.                           */
+/*---------------------------------------------------------------------------*/
+
+class WarmUp {
+public:
+  static const int maxProblems = 8;
+
+  WarmUp() : brain(NULL), problems(0), row(0), startedAt(0), finished(false) {}
+
+  void begin(vex::brain &screen) {
+    brain = &screen;
+    problems = 0;
+    row = 0;
+    finished = false;
+    startedAt = vex::timer::system();
+    brain->Screen.clearScreen();
+    printRow("warming up");
+  }
+
+  // A motor that is unplugged or on the wrong port does not answer
+  bool checkMotor(const char *name, vex::motor &motor) {
+    if (motor.installed())
+      return true;
+    problem(name);
+    printRow("%-10s not found", name);
+    return false;
+  }
+
+  // The gyro has to hold still until it has calibrated, so this waits for it
+  bool calibrateGyro(const char *name, vex::gyro &gyro, uint32_t timeoutMs) {
+    uint32_t start = vex::timer::system();
+    gyro.startCalibration();
+    vex::task::sleep(50);
+    while (gyro.isCalibrating()) {
+      if (vex::timer::system() - start > timeoutMs) {
+        problem(name);
+        printRow("%-10s calibration timed out", name);
+        return false;
+      }
+      vex::task::sleep(20);
+    }
+    printRow("%-10s calibrated %5lums", name,
+             (unsigned long)(vex::timer::system() - start));
+    return true;
+  }
+
+  // Runs one stage, which returns false if the robot is not fit to run
+  bool stage(const char *name, bool (*work)(void)) {
+    uint32_t start = vex::timer::system();
+    bool ok = work();
+    if (!ok)
+      problem(name);
+    printRow("%-10s %-6s %5lums", name, ok ? "ok" : "FAILED",
+             (unsigned long)(vex::timer::system() - start));
+    return ok;
+  }
+
+  // Shows the verdict under the stages
+  void finish() {
+    finished = true;
+    char line[64];
+    if (ready()) {
+      snprintf(line, sizeof(line), "READY in %lums",
+               (unsigned long)(vex::timer::system() - startedAt));
+    } else {
+      int length = snprintf(line, sizeof(line), "CHECK");
+      for (int i = 0; i < problems && length < (int)sizeof(line); i++)
+        length += snprintf(line + length, sizeof(line) - length, " %s",
+                           problemNames[i]);
+    }
+    printRow("%s", line);
+  }
+
+  bool ready() const { return finished && problems == 0; }
+
+  // Short form for a status corner, "ready" or the first thing to check
+  const char *status() const {
+    if (!finished)
+      return "warming up";
+    return problems == 0 ? "ready" : problemNames[0];
+  }
+
+private:
+  vex::brain *brain;
+  const char *problemNames[maxProblems];
+  int problems;
+  int row;
+  uint32_t startedAt;
+  bool finished;
+
+  void problem(const char *name) {
+    if (problems < maxProblems)
+      problemNames[problems++] = name;
+  }
+
+  void printRow(const char *format, ...) {
+    char line[64];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (brain != NULL)
+      brain->Screen.printAt(10, 20 + 20 * row, line);
+    row++;
+  }
+};
+
+#endif
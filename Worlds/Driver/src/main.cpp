@@ -1,6 +1,14 @@
 #include "algorithm"
 #include "math.h"
 #include "robot-config.h"
+#include "latency.h"
+#include "profiler.h"
+#include "recording.h"
+#include "seqlock.h"
+#include "tasks.h"
+#include "traction.h"
+#include "warmup.h"
+#include "watchdog.h"
 
 using namespace vex;
 /*---------------------------------------------------------------------------*/
@@ -12,6 +20,99 @@ using namespace vex;
 // Creates a competition object that allows access to Competition methods.
 vex::competition Competition;
 
+// Watches the drive job and every motion for getting stuck
+Watchdog watchdog;
+int motionWatch = -1;
+
+// ms a motion may go without the wheels moving before it is logged, and
+// before the robot is stopped and the motion abandoned
+const uint32_t motionDeadline = 300;
+const uint32_t motionStopAfter = 1000;
+
+// Everything off, the drive held where it is
+void safeStop() {
+  lf.stop(brakeType::brake);
+  lb.stop(brakeType::brake);
+  rf.stop(brakeType::brake);
+  rb.stop(brakeType::brake);
+  fw.stop(brakeType::coast);
+  fw2.stop(brakeType::coast);
+  in.stop(brakeType::brake);
+  arm.stop(brakeType::hold);
+}
+
+bool robotEnabled() { return Competition.isEnabled(); }
+
+bool watchdogStep() {
+  watchdog.poll();
+  return true;
+}
+
+// What the driver loop, the recorder and the watchdog read from the robot.
+// sampleRobot() is the only place these are read; everyone else copies the
+// latest published state out of robotState. The autonomous motions still
+// read their own encoders, since they close the loop faster than this runs.
+// The fields and units are Skills' less the sensors this robot does not have.
+struct RobotState {
+  uint32_t timeMs;
+
+  // drive encoders in deg, velocities in rpm, currents in amps
+  float lf, lb, rf, rb;
+  float lfVelocity, lbVelocity, rfVelocity, rbVelocity;
+  float lfCurrent, lbCurrent, rfCurrent, rbCurrent;
+
+  float arm;      // revs
+  float flywheel; // average of both flywheel motors, rpm
+};
+
+Seqlock<RobotState> robotState;
+
+const uint32_t samplePeriod = 10;
+
+// The turns measure from zero on lb. What lb had turned before each reset is
+// kept here and published with it, so the drive position never jumps back.
+double lbZeroedTravel = 0;
+
+void zeroTurnEncoder() {
+  lbZeroedTravel += lb.rotation(rotationUnits::deg);
+  lb.resetRotation();
+}
+
+RobotState latestState() { return robotState.read(); }
+
+bool sampleRobot() {
+  RobotState s;
+  s.timeMs = vex::timer::system();
+
+  s.lf = lf.rotation(rotationUnits::deg);
+  s.lb = lb.rotation(rotationUnits::deg) + lbZeroedTravel;
+  s.rf = rf.rotation(rotationUnits::deg);
+  s.rb = rb.rotation(rotationUnits::deg);
+
+  s.lfVelocity = lf.velocity(velocityUnits::rpm);
+  s.lbVelocity = lb.velocity(velocityUnits::rpm);
+  s.rfVelocity = rf.velocity(velocityUnits::rpm);
+  s.rbVelocity = rb.velocity(velocityUnits::rpm);
+
+  s.lfCurrent = lf.current(currentUnits::amp);
+  s.lbCurrent = lb.current(currentUnits::amp);
+  s.rfCurrent = rf.current(currentUnits::amp);
+  s.rbCurrent = rb.current(currentUnits::amp);
+
+  s.arm = arm.rotation(rotationUnits::rev);
+  s.flywheel =
+      (fw.velocity(velocityUnits::rpm) + fw2.velocity(velocityUnits::rpm)) / 2;
+
+  robotState.publish(s);
+  return true;
+}
+
+// Total wheel travel in degrees, goes up whichever way the wheels turn
+double driveTravel() {
+  RobotState s = latestState();
+  return fabs(s.lf) + fabs(s.lb) + fabs(s.rf) + fabs(s.rb);
+}
+
 // A minimum velocity is necessary. This could also be done per command instead
 // of globally.
 double minimum_velocity = 40.0;
@@ -34,6 +135,9 @@ double decreasing_speed(double ending_point, double current_position) {
 // robot in a straight line for that distance using a trapezoidal motion profile
 // controlled by increasing_speed, decreasing_speed, and maxVelocity
 void forward(double distanceIn, double maxVelocity) {
+  PROFILE("forward");
+  static int forwardPass = profiler.scope("forward pass");
+
   // record nominal wheel circumference
   static const double circumference = 3.14159 * 4;
 
@@ -66,15 +170,19 @@ void forward(double distanceIn, double maxVelocity) {
   double rightBStartPoint = rb.rotation(rotationUnits::rev);
   double rightBEndPoint = rightBStartPoint + wheelRevs;
 
+  watchdog.start(motionWatch, driveTravel());
+
   // execute motion profile
-  while ((direction * (rf.rotation(rotationUnits::rev) - rightStartPoint) <
+  while (!watchdog.stopped(motionWatch) &&
+         ((direction * (rf.rotation(rotationUnits::rev) - rightStartPoint) <
           direction * wheelRevs) ||
          (direction * (lf.rotation(rotationUnits::rev) - leftStartPoint) <
           direction * wheelRevs) ||
          (direction * (lb.rotation(rotationUnits::rev) - leftBStartPoint) <
           direction * wheelRevs) ||
          (direction * (rb.rotation(rotationUnits::rev) - rightBStartPoint) <
-          direction * wheelRevs)) {
+          direction * wheelRevs))) {
+    ProfileScope pass(forwardPass);
 
     // set right motor speed to minimum of increasing function, decreasing
     // function, and max velocity, based on current position
@@ -138,7 +246,13 @@ void forward(double distanceIn, double maxVelocity) {
     } else {
       rb.stop(brakeType::brake);
     }
+
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    pass.stop();
+    yieldControl();
   }
+
+  watchdog.finish(motionWatch);
 }
 
 void forward(double distanceIn) {
@@ -170,15 +284,21 @@ void stopC() {
 
 void turnR(int tdistance, int tspeed, int twait) {
   vex::task::sleep(twait);
-  lb.resetRotation();
+  zeroTurnEncoder();
   vex::task::sleep(150);
 
-  while (abs(lb.rotation(vex::rotationUnits::deg)) < tdistance) {
+  watchdog.start(motionWatch, driveTravel());
+
+  while (!watchdog.stopped(motionWatch) &&
+         abs(lb.rotation(vex::rotationUnits::deg)) < tdistance) {
     lf.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     lb.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     rf.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     rb.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    yieldControl();
   }
+  watchdog.finish(motionWatch);
   lf.stop(vex::brakeType::coast);
   lb.stop(vex::brakeType::coast);
   rf.stop(vex::brakeType::coast);
@@ -187,15 +307,21 @@ void turnR(int tdistance, int tspeed, int twait) {
 
 void turnL(int tdistance, int tspeed, int twait) {
   vex::task::sleep(twait);
-  lb.resetRotation();
+  zeroTurnEncoder();
   vex::task::sleep(150);
 
-  while (abs(lb.rotation(vex::rotationUnits::deg)) < tdistance) {
+  watchdog.start(motionWatch, driveTravel());
+
+  while (!watchdog.stopped(motionWatch) &&
+         abs(lb.rotation(vex::rotationUnits::deg)) < tdistance) {
     lf.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     lb.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     rf.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     rb.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    yieldControl();
   }
+  watchdog.finish(motionWatch);
   lf.stop(vex::brakeType::coast);
   lb.stop(vex::brakeType::coast);
   rf.stop(vex::brakeType::coast);
@@ -303,6 +429,7 @@ int correct() {
       lb.spin(vex::directionType::fwd, -15, vex::velocityUnits::rpm);
       rf.spin(vex::directionType::fwd, 15, vex::velocityUnits::rpm);
       rb.spin(vex::directionType::fwd, 15, vex::velocityUnits::rpm);
+      yieldControl();
     }
     lf.stop(vex::brakeType::coast);
     lb.stop(vex::brakeType::coast);
@@ -320,6 +447,7 @@ int correct() {
       lb.spin(vex::directionType::fwd, 15, vex::velocityUnits::rpm);
       rf.spin(vex::directionType::fwd, -15, vex::velocityUnits::rpm);
       rb.spin(vex::directionType::fwd, -15, vex::velocityUnits::rpm);
+      yieldControl();
     }
     lf.stop(vex::brakeType::coast);
     lb.stop(vex::brakeType::coast);
@@ -329,6 +457,182 @@ int correct() {
   return (0);
 }
 
+/*---------------------------------------------------------------------------*/
+/*                          Record and Replay                                */
+/*                                                                           */
+/*  ButtonRight on the first controller starts and stops recording while     */
+/*  driving, and the recording is saved to the SD card. Autonomous replays   */
+/*  it instead of the routine below, following the recorded wheel travel,    */
+/*  only once ButtonA has armed it while the robot is disabled. The Brain    */
+/*  and the controller show whether the route or the routine will run.       */
+/*---------------------------------------------------------------------------*/
+
+Recording route;
+const char *routeFile = "route.rpl";
+const uint8_t recordPeriod = 20;
+
+// percent of extra drive command per degree the wheels lag the recording
+const double replayGain = 0.5;
+
+// What the driver loop is currently asking for, sampled by the recorder
+volatile int leftCommand = 0;
+volatile int rightCommand = 0;
+volatile int intakeCommand = 0;
+volatile int armCommand = 0;
+volatile int flywheelCommand = 0;
+
+volatile bool recording = false;
+volatile bool replayArmed = false;
+
+double leftPosition() {
+  RobotState s = latestState();
+  return (s.lf + s.lb) / 2;
+}
+
+double rightPosition() {
+  RobotState s = latestState();
+  return (s.rf + s.rb) / 2;
+}
+
+int clampCommand(int value, int limit) {
+  return std::max(-limit, std::min(limit, value));
+}
+
+// Sleep until an absolute time so the frame rate does not drift
+void sleepUntil(uint32_t wakeTime) {
+  int32_t wait = (int32_t)(wakeTime - vex::timer::system());
+  if (wait > 0)
+    vex::task::sleep(wait);
+}
+
+// drive position the stored frames add up to, so rounding never builds up
+double recordedLeft = 0;
+double recordedRight = 0;
+bool recorderRunning = false;
+
+// One frame of the recorder, run every recordPeriod by the task runtime
+bool recordStep() {
+  if (recording && !recorderRunning) {
+    route.clear(recordPeriod);
+    recordedLeft = leftPosition();
+    recordedRight = rightPosition();
+    recorderRunning = true;
+  }
+
+  if (!recorderRunning)
+    return true;
+
+  if (recording && !route.full()) {
+    RecordedFrame frame;
+    frame.leftDelta = clampCommand((leftPosition() - recordedLeft) * 10, 32767);
+    frame.rightDelta =
+        clampCommand((rightPosition() - recordedRight) * 10, 32767);
+    recordedLeft += frame.leftDelta / 10.0;
+    recordedRight += frame.rightDelta / 10.0;
+
+    frame.leftCommand = clampCommand(leftCommand, 100);
+    frame.rightCommand = clampCommand(rightCommand, 100);
+    frame.intake = clampCommand(intakeCommand / 10, 127);
+    frame.arm = clampCommand(armCommand, 127);
+    frame.flywheel = flywheelCommand;
+    route.add(frame);
+    return true;
+  }
+
+  recording = false;
+  recorderRunning = false;
+  Controller1.Screen.clearLine(3);
+  if (route.save(Brain, routeFile) > 0)
+    Controller1.Screen.print("saved %d frames", route.count());
+  else
+    Controller1.Screen.print("no SD card");
+  return true;
+}
+
+// Says what autonomous will run, on the Brain next to the warm-up and on the
+// controller
+void showReplay() {
+  char line[32], padded[32];
+  if (replayArmed)
+    snprintf(line, sizeof(line), "replay %d frames", route.count());
+  else
+    snprintf(line, sizeof(line), "routine, no replay");
+  // padded so a shorter line covers a longer one
+  snprintf(padded, sizeof(padded), "%-20s", line);
+  Brain.Screen.printAt(250, 20, padded);
+  Controller1.Screen.clearLine(3);
+  Controller1.Screen.print("%s", line);
+}
+
+// A route only replays when it has been armed, not because a file is on the
+// card. Arming is refused while enabled, so a stray press in a match does
+// nothing.
+void toggleReplay() {
+  if (Competition.isEnabled())
+    return;
+  if (!replayArmed && route.count() == 0 && !route.load(Brain, routeFile)) {
+    Controller1.Screen.clearLine(3);
+    Controller1.Screen.print("no route to replay");
+    return;
+  }
+  replayArmed = !replayArmed;
+  showReplay();
+}
+
+void toggleRecording() {
+  recording = !recording;
+  if (recording) {
+    // a new route has to be armed again before it replays
+    replayArmed = false;
+    Controller1.Screen.clearLine(3);
+    Controller1.Screen.print("recording");
+  }
+}
+
+// Drive the recorded wheel travel back, using the recorded commands as the
+// base speed and correcting toward the recorded encoder positions
+void replayRoute(const Recording &recorded) {
+  double leftTarget = leftPosition();
+  double rightTarget = rightPosition();
+  uint32_t next = vex::timer::system();
+
+  for (int i = 0; i < recorded.count(); i++) {
+    RecordedFrame frame = recorded.frame(i);
+    leftTarget += frame.leftDelta / 10.0;
+    rightTarget += frame.rightDelta / 10.0;
+
+    double left =
+        frame.leftCommand + replayGain * (leftTarget - leftPosition());
+    double right =
+        frame.rightCommand + replayGain * (rightTarget - rightPosition());
+
+    lf.spin(directionType::fwd, left, velocityUnits::pct);
+    lb.spin(directionType::fwd, left, velocityUnits::pct);
+    rf.spin(directionType::fwd, right, velocityUnits::pct);
+    rb.spin(directionType::fwd, right, velocityUnits::pct);
+
+    if (frame.intake == 0)
+      in.stop();
+    else
+      in.spin(directionType::fwd, frame.intake * 10, velocityUnits::rpm);
+
+    if (frame.arm == 0)
+      arm.stop();
+    else
+      arm.spin(directionType::fwd, frame.arm, velocityUnits::rpm);
+
+    fw.spin(directionType::fwd, frame.flywheel, velocityUnits::rpm);
+    fw2.spin(directionType::fwd, frame.flywheel, velocityUnits::rpm);
+
+    next += recorded.periodMs();
+    sleepUntil(next);
+  }
+
+  stopH();
+  in.stop();
+  arm.stop(brakeType::hold);
+}
+
 /*---------------------------------------------------------------------------*/
 /*                          Pre-Autonomous Functions                         */
 /*                                                                           */
@@ -339,9 +643,53 @@ int correct() {
 /*  not every time that the robot is disabled.                               */
 /*---------------------------------------------------------------------------*/
 
+WarmUp warmUp;
+
+bool zeroEncoders() {
+  lf.resetRotation();
+  lb.resetRotation();
+  lbZeroedTravel = 0;
+  rf.resetRotation();
+  rb.resetRotation();
+  arm.resetRotation();
+  return true;
+}
+
+// Stopping modes autonomous expects, so the first command needs no setup
+bool setStoppingModes() {
+  fw.setStopping(brakeType::coast);
+  fw2.setStopping(brakeType::coast);
+  arm.setStopping(brakeType::hold);
+  in.setStopping(brakeType::brake);
+  return true;
+}
+
+// Reading and checking the recorded route off the SD card is the slowest part
+// of arming a replay, so do it now. No route is fine, the routine runs.
+bool loadRoute() {
+  route.load(Brain, routeFile);
+  showReplay();
+  return true;
+}
+
 void pre_auton(void) {
   // All activities that occur before the competition starts
-  // Example: clearing encoders, setting servo positions, ...
+  warmUp.begin(Brain);
+
+  warmUp.checkMotor("lf", lf);
+  warmUp.checkMotor("lb", lb);
+  warmUp.checkMotor("rf", rf);
+  warmUp.checkMotor("rb", rb);
+  warmUp.checkMotor("fw", fw);
+  warmUp.checkMotor("fw2", fw2);
+  warmUp.checkMotor("in", in);
+  warmUp.checkMotor("arm", arm);
+
+  warmUp.stage("encoders", zeroEncoders);
+  warmUp.stage("stopping", setStoppingModes);
+  warmUp.stage("route", loadRoute);
+
+  warmUp.finish();
 }
 
 /*---------------------------------------------------------------------------*/
@@ -355,6 +703,18 @@ void pre_auton(void) {
 /*---------------------------------------------------------------------------*/
 
 void autonomous(void) {
+  PROFILE("autonomous");
+
+  // the competition ended driver control without telling the drive job
+  stopTask(findTask("drive"));
+
+  // an armed route takes the place of the routine below. It is loaded during
+  // warm-up or when it is armed.
+  if (replayArmed && route.count() > 0) {
+    replayRoute(route);
+    return;
+  }
+
   fwStart(200);
   armUp();
 
@@ -466,73 +826,160 @@ void alignBlueP4() {
   pivotRight(110);
 }
 
-void usercontrol(void) {
-  while (1) {
-    int fwSpeed = 500;
-
-    while (true) {
-      // Second Controller
-
-      // Flywheel Speed Settings
-      if (Controller2.ButtonX.pressing()) {
-        fwSpeed = 57;
-      } else if (Controller2.ButtonA.pressing()) {
-        fwSpeed = 100;
-      } else {
-        fwSpeed = 500;
-      }
-
-      Controller2.ButtonL1.pressed(alignRedP3);
-      Controller2.ButtonL2.pressed(alignRedP4);
-
-      Controller2.ButtonR1.pressed(alignBlueP1);
-      Controller2.ButtonR2.pressed(alignBlueP2);
-
-      // First Controller
-
-      // Regular Driver Control
-      lf.spin(vex::directionType::fwd,
-              (Controller1.Axis3.value() + Controller1.Axis1.value()),
-              vex::velocityUnits::pct);
-      rf.spin(vex::directionType::fwd,
-              (Controller1.Axis3.value() - Controller1.Axis1.value()),
-              vex::velocityUnits::pct);
-      lb.spin(vex::directionType::fwd,
-              (Controller1.Axis3.value() + Controller1.Axis1.value()),
-              vex::velocityUnits::pct);
-      rb.spin(vex::directionType::fwd,
-              (Controller1.Axis3.value() - Controller1.Axis1.value()),
-              vex::velocityUnits::pct);
-
-      if (Controller1.ButtonR1.pressing()) {
-        in.spin(directionType::rev, 600, velocityUnits::rpm);
-      } else if (Controller1.ButtonR2.pressing()) {
-        in.spin(directionType::fwd, 600, velocityUnits::rpm);
-      } else {
-        in.stop();
-      }
-
-      if (Controller1.ButtonL1.pressing()) {
-        arm.spin(directionType::fwd, 100, velocityUnits::rpm);
-      } else if (Controller1.ButtonL2.pressing()) {
-        arm.spin(directionType::rev, 100, velocityUnits::rpm);
-      } else {
-        arm.stop();
-      }
-
-      Controller1.ButtonUp.released(alignRedP1);
-      Controller1.ButtonDown.pressed(alignRedP2);
-
-      Controller1.ButtonX.pressed(alignBlueP3);
-      Controller1.ButtonB.pressed(alignBlueP4);
-
-      fw.spin(directionType::fwd, fwSpeed, velocityUnits::rpm);
-      fw2.spin(directionType::fwd, fwSpeed, velocityUnits::rpm);
-    }
+// Timing from a drive stick change to the matching drive motor command
+LatencyProbe driveLatency;
+
+void stickChanged() { driveLatency.stickChanged(); }
+
+void saveReports() {
+  driveLatency.save(Brain, "latency.csv");
+  watchdog.save(Brain, "overruns.csv");
+  profiler.save(Brain, "profile.csv");
+  Controller1.Screen.clearLine(3);
+  Controller1.Screen.print("reports saved");
+}
 
-    vex::task::sleep(20); // Sleep the task for a short amount of time to
-                          // prevent wasted resources.
+// ButtonLeft flips the Brain screen between timing and the profiler
+volatile bool showProfile = false;
+bool profileShown = false;
+
+void toggleProfile() { showProfile = !showProfile; }
+
+// Redraw the latency and overrun numbers twice a second, well away from the
+// drive loop
+bool latencyDisplay() {
+  if (showProfile != profileShown) {
+    profileShown = showProfile;
+    Brain.Screen.clearScreen();
+  }
+
+  if (profileShown) {
+    profiler.print(Brain, 20, 11);
+  } else {
+    watchdog.print(Brain, 20, 3);
+    driveLatency.print(Brain, 160);
   }
+  return true;
+}
+
+// Acceleration and wheelspin limits for each side of the drive
+TractionControl leftTraction;
+TractionControl rightTraction;
+
+const uint32_t drivePeriod = 10;
+
+// Drive motors are on the 200 rpm cartridge, and traction works in percent
+const double driveMaxRpm = 200;
+
+double drivePercent(double rpm) { return rpm * 100 / driveMaxRpm; }
+
+int lastDrive = 0;
+int lastTurn = 0;
+uint64_t lastTick = 0;
+
+// One pass of driver control
+bool driveStep() {
+  // Second Controller
+
+  // Flywheel Speed Settings
+  int fwSpeed = 500;
+  if (Controller2.ButtonX.pressing()) {
+    fwSpeed = 57;
+  } else if (Controller2.ButtonA.pressing()) {
+    fwSpeed = 100;
+  }
+
+  // First Controller
+
+  // Regular Driver Control
+  // read the sticks once so every drive motor gets the same sample
+  int drive = Controller1.Axis3.value();
+  int turn = Controller1.Axis1.value();
+  driveLatency.sampled(drive != lastDrive || turn != lastTurn);
+  lastDrive = drive;
+  lastTurn = turn;
+
+  // limit against real time in case a pass runs late
+  uint64_t tick = vex::timer::systemHighResolution();
+  double dt = (tick - lastTick) / 1000000.0;
+  lastTick = tick;
+
+  RobotState s = latestState();
+  double left = leftTraction.update(
+      drive + turn, drivePercent(s.lfVelocity + s.lbVelocity) / 2, dt);
+  double right = rightTraction.update(
+      drive - turn, drivePercent(s.rfVelocity + s.rbVelocity) / 2, dt);
+
+  lf.spin(vex::directionType::fwd, left, vex::velocityUnits::pct);
+  rf.spin(vex::directionType::fwd, right, vex::velocityUnits::pct);
+  lb.spin(vex::directionType::fwd, left, vex::velocityUnits::pct);
+  rb.spin(vex::directionType::fwd, right, vex::velocityUnits::pct);
+  driveLatency.commanded();
+  leftCommand = left;
+  rightCommand = right;
+
+  if (Controller1.ButtonR1.pressing()) {
+    in.spin(directionType::rev, 600, velocityUnits::rpm);
+    intakeCommand = -600;
+  } else if (Controller1.ButtonR2.pressing()) {
+    in.spin(directionType::fwd, 600, velocityUnits::rpm);
+    intakeCommand = 600;
+  } else {
+    in.stop();
+    intakeCommand = 0;
+  }
+
+  if (Controller1.ButtonL1.pressing()) {
+    arm.spin(directionType::fwd, 100, velocityUnits::rpm);
+    armCommand = 100;
+  } else if (Controller1.ButtonL2.pressing()) {
+    arm.spin(directionType::rev, 100, velocityUnits::rpm);
+    armCommand = -100;
+  } else {
+    arm.stop();
+    armCommand = 0;
+  }
+
+  fw.spin(directionType::fwd, fwSpeed, velocityUnits::rpm);
+  fw2.spin(directionType::fwd, fwSpeed, velocityUnits::rpm);
+  flywheelCommand = fwSpeed;
+  return true;
+}
+
+void usercontrol(void) {
+  // button events only need registering once
+  Controller2.ButtonL1.pressed(alignRedP3);
+  Controller2.ButtonL2.pressed(alignRedP4);
+
+  Controller2.ButtonR1.pressed(alignBlueP1);
+  Controller2.ButtonR2.pressed(alignBlueP2);
+
+  Controller1.ButtonUp.released(alignRedP1);
+  Controller1.ButtonDown.pressed(alignRedP2);
+
+  Controller1.ButtonX.pressed(alignBlueP3);
+  Controller1.ButtonB.pressed(alignBlueP4);
+
+  Controller1.Axis1.changed(stickChanged);
+  Controller1.Axis3.changed(stickChanged);
+  Controller1.ButtonY.pressed(saveReports);
+  Controller1.ButtonRight.pressed(toggleRecording);
+  Controller1.ButtonLeft.pressed(toggleProfile);
+
+  // startTask refuses a job that is already running, so the watches are
+  // only added the first time through
+  watchdog.watchTask(startTask("latency display", uiTask, latencyDisplay, 500),
+                     2000, 0);
+  watchdog.watchTask(
+      startTask("recorder", sensingTask, recordStep, recordPeriod), 100, 0);
+
+  static int driveWatch = -1;
+  if (driveWatch < 0)
+    driveWatch = watchdog.watchTask(
+        registerTask("drive", controlTask, driveStep, drivePeriod), 50, 250);
+
+  lastTick = vex::timer::systemHighResolution();
+  runTask("drive", controlTask, driveStep, drivePeriod);
 }
 
 //
@@ -542,6 +989,14 @@ int main() {
 
   // Run the pre-autonomous function.
   pre_auton();
+  Controller1.ButtonA.pressed(toggleReplay);
+
+  watchdog.setSafeStop(safeStop);
+  watchdog.setEnabled(robotEnabled);
+  motionWatch = watchdog.watch("motion", motionDeadline, motionStopAfter);
+  startTask("watchdog", sensingTask, watchdogStep, 10);
+  watchdog.watchTask(
+      startTask("sensors", sensingTask, sampleRobot, samplePeriod), 60, 0);
 
   // Set up callbacks for autonomous and driver control periods.
   Competition.autonomous(autonomous);
@@ -0,0 +1,201 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------*/
+/*                                Simulator                                  */
+/*                                                                           */
+/*  The host stand-in for the Brain and the robot. The vex classes in        */
+/*  v5_vcs.h are handles onto the devices here, and every call through them  */
+/*  first brings the plant up to the present in fixed 1 ms steps. Motor      */
+/*  positions are kept the way the program sees them, after the reversal in  */
+/*  robot-config.h, so a positive drive command moves the robot forward.     */
+/*                                                                           */
+/*  The field is 144 in square with the origin in a corner. Headings are in  */
+/*  degrees from the +y axis, clockwise positive like the gyro.              */
+/*---------------------------------------------------------------------------*/
+
+namespace sim {
+
+const int portCount = 21;
+const int triportCount = 8;
+const double fieldSize = 144; // inches
+const double stepMs = 1;
+
+enum MotorMode {
+  motorCoasting,
+  motorBraking,
+  motorHolding,
+  motorVelocity,
+  motorPosition
+};
+
+struct Motor {
+  bool used;
+  double maxRpm; // of the cartridge
+  double ticksPerRev;
+
+  // what the program asked for
+  double velocity;    // rpm that spin(dir) runs at, signed
+  int direction;      // of the last spin, 1 or -1
+  MotorMode stopping; // what stop() does
+  MotorMode mode;
+  double targetRpm;  // velocity and position moves, signed
+  double targetRevs; // position moves and hold
+  double timeoutMs;  // of a position move, 0 for none
+  double moveStarted;
+  bool moveDone;
+
+  // what the plant reports
+  double revs;
+  double rpm;
+  double amps;
+};
+
+struct Pose {
+  double x, y;    // inches
+  double heading; // degrees, clockwise
+};
+
+// Which ports drive what, and the robot the plant moves. The defaults are
+// the robot in robot-config.h; the numbers are measured or close guesses.
+struct Robot {
+  int leftDrive[2];  // front, back
+  int rightDrive[2]; // front, back
+  int flywheel[2];
+  int intake;
+  int arm;
+
+  // chassis
+  double mass;          // kg
+  double wheelDiameter; // inches
+  double trackWidth;    // inches between the left and right wheels
+  double wheelBase;     // inches between the front and back wheels
+  double length;        // inches, front to back
+  double width;         // inches
+  double grip;          // tire friction coefficient along the wheel
+  double sideGrip;      // and across it
+  double gripBalance;   // left wheels grip 1 + this as much, right 1 - this
+  double slipSpeed;     // m/s of slip for a tire to reach full grip
+  double rolling;       // rolling resistance coefficient on the tiles
+  double wheelInertia;  // kg m^2 at each drive motor's output shaft
+
+  // mechanisms, inertia at the motor's output shaft
+  double flywheelInertia; // kg m^2
+  double intakeInertia;   // kg m^2, and any other motor
+  double armInertia;      // kg m^2
+  double armGravity;      // Nm with the arm level
+  double armLowest;       // revs from where it starts
+  double armHighest;
+
+  // battery
+  double batteryCharge;     // 0..1 at the start
+  double batteryResistance; // ohms, with the wiring
+
+  // sensors, ideal at 0
+  double gyroNoise;  // degrees, standard deviation of each reading
+  double gyroDrift;  // degrees per second
+  double sonarNoise; // inches, standard deviation of each reading
+};
+
+// The numbers in Robot by name, for setting them from the command line
+struct Parameter {
+  const char *name;
+  double *value;
+};
+
+extern const Parameter parameters[];
+extern const int parameterCount;
+bool setParameter(const char *name, double value);
+
+enum Period { autonomousPeriod, driverPeriod, skillsPeriod };
+
+struct Options {
+  Period period;
+  uint32_t periodMs;
+  Pose start;
+  const char *sdDirectory;
+  const char *tracePath;
+  uint32_t traceEveryMs;
+  const char *stepsPath;  // where to write the steps the run made
+  const char *expectPath; // steps a run has to match
+  bool echoScreen;
+  int selectorMask; // buttons held on a program's selector, -1 to leave them
+};
+
+extern Robot robot;
+extern Motor motors[portCount];
+
+// Time and locking. Every device access holds the lock, which charges the
+// running task for the call, may hand over to the next task first and brings
+// the plant up to now. No other task runs while the lock is held.
+void start(const Options &options);
+double now(); // virtual ms since the program started
+uint64_t nowMicros();
+void lock();
+void unlock();
+
+class Guard {
+public:
+  Guard() { lock(); }
+  ~Guard() { unlock(); }
+};
+
+// The plant, called with the lock held. pose() is where the robot really
+// is; the sensors read it with the noise and drift in Robot.
+void resetPlant(const Pose &start);
+void stepPlant(double dt);
+Pose pose();
+double gyroHeading();
+double sonarInches();
+int32_t lineReflection(); // 0..4095, darker is higher
+double batteryPercent();
+
+// Pseudo-random numbers for noise and for varying runs. The sequence only
+// depends on the seed, 1 unless set.
+void seedRandom(uint32_t seed);
+double random();           // uniform in [0, 1)
+double noise(double sigma); // normal, mean 0
+
+// The device behind a motor port, lock held
+Motor &motor(int port);
+
+// Tasks, run cooperatively in a fixed order whatever their priority. A
+// stopped task is never resumed.
+typedef int (*TaskEntry)(void);
+int startTask(TaskEntry entry, int32_t priority);
+void stopTask(int task);
+void sleepMs(uint32_t ms);
+
+// Runs the tasks until the period is over or watch returns false. watch is
+// called with the lock held after each simulated ms, or after the slice that
+// took time past it.
+void run(bool (*watch)(double time));
+
+// Competition. The callback for the period being run starts as soon as the
+// program registers it.
+void competitionCallback(bool autonomous, void (*callback)(void));
+// Stops the callback's task, for a runner that takes the robot over from it
+void stopPeriod();
+bool inPeriod(Period period);
+bool periodOver();
+
+// Brain and controller screens
+void screenText(const char *where, const char *text);
+
+// Sets the on-screen selector buttons of a program that has them, bit i for
+// button i, as if they had been pressed before the match. Returns false if
+// the program has no selector.
+bool pressSelector(int mask);
+
+// SD card, files under the directory given in the options
+bool sdInserted();
+int32_t sdLoad(const char *name, uint8_t *buffer, int32_t length);
+int32_t sdSave(const char *name, const uint8_t *buffer, int32_t length,
+               bool append);
+int32_t sdSize(const char *name);
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef STEPS_H
+#define STEPS_H
+
+#include "sim.h"
+
+/*---------------------------------------------------------------------------*/
+/*                                  Steps                                    */
+/*                                                                           */
+/*  A run split where the drive comes to rest: a step ends once the drive    */
+/*  has been still for a moment after moving, and is where the robot and     */
+/*  its mechanisms were when it stopped. Runs are compared step by step,     */
+/*  with the end of the run as one more step.                                */
+/*---------------------------------------------------------------------------*/
+
+namespace sim {
+
+struct Step {
+  double time;
+  Pose at;
+  double flywheelRpm;
+  double flywheelTargetRpm[2]; // each motor's, 0 when it is not driven
+  double intakeRpm;
+  double armRevs;
+};
+
+const int maxSteps = 256;
+
+// How far a step may be from the one expected
+extern const Step stepTolerance;
+
+// Lock held. watchSteps is called from the run's watch.
+Step snapshot(double time);
+void watchSteps(double time);
+int stepCount();
+const Step &step(int index);
+
+// Files of steps, one CSV row each, with the end of the run last
+bool writeSteps(const char *path, const Step &end);
+int readSteps(const char *path, Step *read, int most); // -1 if unreadable
+
+// Whether got is within slack times the tolerance of expected, printing
+// what differs if say is set
+bool sameStep(const char *name, const Step &got, const Step &expected,
+              double slack, bool say);
+
+} // namespace sim
+
+#endif
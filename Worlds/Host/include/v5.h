@@ -0,0 +1,19 @@
+#ifndef V5_H
+#define V5_H
+
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------*/
+/*                               Host v5.h                                   */
+/*                                                                           */
+/*  Stands in for the SDK header of the same name when the programs are      */
+/*  built for the host. Only the system calls the programs can reach are     */
+/*  here; the rest of the API is in v5_vcs.h.                                */
+/*---------------------------------------------------------------------------*/
+
+extern "C" {
+uint32_t vexSystemTimeGet(void);
+uint64_t vexSystemHighResolutionTimeGet(void);
+}
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef V5_VCS_H
+#define V5_VCS_H
+
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------*/
+/*                             Host v5_vcs.h                                 */
+/*                                                                           */
+/*  The part of the vex API the Worlds programs use, with the same names and */
+/*  signatures as the SDK, backed by the simulator in sim.h. Devices are     */
+/*  only a port number; everything they know lives in the simulator, the     */
+/*  way a V5 device keeps its state on its port rather than in the program.  */
+/*---------------------------------------------------------------------------*/
+
+namespace vex {
+
+enum class timeUnits { sec, msec };
+enum class velocityUnits { pct, rpm, dps };
+enum class rotationUnits { deg, rev, raw };
+enum class directionType { fwd, rev, undefined };
+enum class brakeType { coast, brake, hold, undefined };
+enum class gearSetting { ratio36_1, ratio18_1, ratio6_1 };
+enum class currentUnits { amp };
+enum class percentUnits { pct };
+enum class analogUnits { pct, range8bit, range10bit, range12bit, mV };
+enum class distanceUnits { mm, in, cm };
+enum class controllerType { primary, partner };
+enum class temperatureUnits { celsius, fahrenheit };
+enum class fontType {
+  mono20,
+  mono30,
+  mono40,
+  mono60,
+  prop20,
+  prop30,
+  prop40,
+  prop60,
+  mono15,
+  mono12
+};
+
+enum {
+  PORT1 = 0,
+  PORT2,
+  PORT3,
+  PORT4,
+  PORT5,
+  PORT6,
+  PORT7,
+  PORT8,
+  PORT9,
+  PORT10,
+  PORT11,
+  PORT12,
+  PORT13,
+  PORT14,
+  PORT15,
+  PORT16,
+  PORT17,
+  PORT18,
+  PORT19,
+  PORT20,
+  PORT21
+};
+
+class color {
+public:
+  color() : rgb(0), clear(false) {}
+  color(int value) : rgb((uint32_t)value), clear(false) {}
+
+  static const color transparent;
+  static const color black, white, red, green, blue, yellow;
+
+  uint32_t rgb;
+  bool clear;
+};
+
+class motor {
+public:
+  motor(int32_t index, bool reverse = false);
+  motor(int32_t index, gearSetting gears, bool reverse = false);
+
+  void spin(directionType dir);
+  void spin(directionType dir, double velocity, velocityUnits units);
+  void setVelocity(double velocity, velocityUnits units);
+  void stop();
+  void stop(brakeType mode);
+  void setStopping(brakeType mode);
+  void setTimeout(int32_t time, timeUnits units);
+
+  bool rotateTo(double rotation, rotationUnits units, double velocity,
+                velocityUnits units_v, bool waitForCompletion = true);
+  bool rotateFor(double rotation, rotationUnits units, double velocity,
+                 velocityUnits units_v, bool waitForCompletion = true);
+  bool rotateFor(directionType dir, double rotation, rotationUnits units,
+                 bool waitForCompletion = true);
+  bool rotateFor(double rotation, rotationUnits units,
+                 bool waitForCompletion = true);
+
+  double rotation(rotationUnits units);
+  void resetRotation();
+  void setRotation(double value, rotationUnits units);
+  double velocity(velocityUnits units);
+  double current(currentUnits units);
+  double temperature(temperatureUnits units);
+  bool installed();
+  bool isSpinning();
+
+private:
+  int32_t port;
+
+  bool moveTo(double revs, double rpm, bool waitForCompletion);
+};
+
+class triport {
+public:
+  class port {
+  public:
+    port(int32_t index) : index(index) {}
+    int32_t index;
+  };
+
+  triport() : A(0), B(1), C(2), D(3), E(4), F(5), G(6), H(7) {}
+  port A, B, C, D, E, F, G, H;
+};
+
+class timer {
+public:
+  timer();
+  double time(timeUnits units);
+  double time();
+  void clear();
+  uint32_t value();
+
+  static uint32_t system();
+  static uint64_t systemHighResolution();
+
+private:
+  double startedAt;
+};
+
+class brain {
+public:
+  class lcd {
+  public:
+    lcd() : x(0), y(0) {}
+    void print(const char *format, ...);
+    void printAt(int32_t x, int32_t y, const char *format, ...);
+    void printAt(int32_t x, int32_t y, bool opaque, const char *format, ...);
+    void setCursor(int32_t row, int32_t col);
+    void newLine();
+    void clearScreen();
+    void clearScreen(const color &c);
+    void clearLine();
+    void clearLine(int32_t number);
+    void setFont(fontType font);
+    void setPenColor(const color &c);
+    void setFillColor(const color &c);
+    void setPenWidth(uint32_t width);
+    void drawLine(int x1, int y1, int x2, int y2);
+    void drawRectangle(int x, int y, int width, int height);
+    void drawRectangle(int x, int y, int width, int height, const color &c);
+    int32_t xPosition();
+    int32_t yPosition();
+    void pressed(void (*callback)(void));
+    void released(void (*callback)(void));
+    bool render();
+    bool render(bool vsyncWait, bool runScheduler = true);
+
+  private:
+    int32_t x, y;
+  };
+
+  class battery {
+  public:
+    uint32_t capacity(percentUnits units = percentUnits::pct);
+    double temperature(percentUnits units = percentUnits::pct);
+  };
+
+  class sdcard {
+  public:
+    bool isInserted();
+    int32_t loadfile(const char *name, uint8_t *buffer, int32_t len);
+    int32_t savefile(const char *name, uint8_t *buffer, int32_t len);
+    int32_t appendfile(const char *name, uint8_t *buffer, int32_t len);
+    int32_t size(const char *name);
+    bool exists(const char *name);
+  };
+
+  lcd Screen;
+  timer Timer;
+  battery Battery;
+  sdcard SDcard;
+  triport ThreeWirePort;
+};
+
+class gyro {
+public:
+  gyro(triport::port &port);
+  double value(rotationUnits units);
+  void startCalibration(int32_t value = 0);
+  bool isCalibrating();
+
+private:
+  int32_t index;
+};
+
+class sonar {
+public:
+  sonar(triport::port &port);
+  double distance(distanceUnits units);
+
+private:
+  int32_t index;
+};
+
+class line {
+public:
+  line(triport::port &port);
+  int32_t value(analogUnits units);
+
+private:
+  int32_t index;
+};
+
+class vision {
+public:
+  class signature {
+  public:
+    signature(int32_t id, int32_t uMin, int32_t uMax, int32_t uMean,
+              int32_t vMin, int32_t vMax, int32_t vMean, double range,
+              int32_t type)
+        : id(id) {}
+    int32_t id;
+  };
+
+  vision(int32_t index, uint8_t brightness) : objectCount(0) {}
+  template <class... Signatures>
+  vision(int32_t index, uint8_t brightness, Signatures &...)
+      : objectCount(0) {}
+
+  // Nothing on the simulated field is in sight
+  int32_t takeSnapshot(uint32_t id) { return objectCount = 0; }
+  int32_t takeSnapshot(signature &sig) { return objectCount = 0; }
+
+  int32_t objectCount;
+};
+
+// Nobody holds the controllers on the host: the sticks sit at zero and no
+// button is ever pressed.
+class controller {
+public:
+  class axis {
+  public:
+    int32_t value() { return 0; }
+    int32_t position(percentUnits units) { return 0; }
+    void changed(void (*callback)(void)) {}
+  };
+
+  class button {
+  public:
+    bool pressing() { return false; }
+    void pressed(void (*callback)(void)) {}
+    void released(void (*callback)(void)) {}
+  };
+
+  class lcd {
+  public:
+    void print(const char *format, ...);
+    void setCursor(int32_t row, int32_t col) {}
+    void clearScreen() {}
+    void clearLine(int32_t number) {}
+  };
+
+  controller() {}
+  controller(controllerType id) {}
+
+  axis Axis1, Axis2, Axis3, Axis4;
+  button ButtonL1, ButtonL2, ButtonR1, ButtonR2, ButtonUp, ButtonDown,
+      ButtonLeft, ButtonRight, ButtonX, ButtonB, ButtonY, ButtonA;
+  lcd Screen;
+};
+
+class competition {
+public:
+  void autonomous(void (*callback)(void));
+  void drivercontrol(void (*callback)(void));
+  bool isEnabled();
+  bool isAutonomous();
+  bool isDriverControl();
+  bool isCompetitionSwitch() { return false; }
+  bool isFieldControl() { return false; }
+};
+
+class task {
+public:
+  static const int32_t taskPrioritylow = 1;
+  static const int32_t taskPriorityNormal = 7;
+  static const int32_t taskPriorityHigh = 15;
+
+  task() {}
+  task(int (*callback)(void));
+  task(int (*callback)(void), int32_t priority);
+
+  static void sleep(uint32_t time);
+  static void yield();
+};
+
+class mutex {
+public:
+  mutex();
+  ~mutex();
+  void lock();
+  bool try_lock();
+  void unlock();
+
+private:
+  void *handle;
+};
+
+namespace this_thread {
+void sleep_for(uint32_t time);
+void yield();
+} // namespace this_thread
+
+} // namespace vex
+
+#endif
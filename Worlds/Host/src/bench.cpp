@@ -0,0 +1,404 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+/*---------------------------------------------------------------------------*/
+/*                             Motion Benchmark                              */
+/*                                                                           */
+/*  Runs a program's own motion primitives over a grid of targets and        */
+/*  speeds and prints one CSV row per move. The primitives are linked from   */
+/*  the program as weak symbols, so a program without one just has no rows   */
+/*  for it, and one with none of them is reported on stderr. AutonSelector's */
+/*  forward() and turn() take a minimum speed and a deadline too, and have   */
+/*  their own grids under the same names.                                    */
+/*                                                                           */
+/*  Each move is a fresh run in its own process. The program's main is run   */
+/*  until it or its autonomous first drives, so whatever tasks and settings  */
+/*  it sets up are in place, then both are stopped, the drive is braked and  */
+/*  the move starts from rest. forward is followed by the program's stopH(), */
+/*  as the programs call it, so the drive holds where the move left it.      */
+/*  Moves are measured on the plant, not the program's sensors:              */
+/*                                                                           */
+/*    forward    inches along the starting heading                           */
+/*    turn       degrees of heading, against the wheel travel it asks for    */
+/*    turnR      degrees of heading, against the encoder travel it asks for  */
+/*    gyroL      degrees of heading                                          */
+/*    sonarmove  inches the rear sonar reads                                 */
+/*                                                                           */
+/*  Times are ms from the call. reached is when the move first got within    */
+/*  tolerance of the goal and settled is when it stayed within tolerance of  */
+/*  where it ended up, -1 for never. overshoot and final_error are in the    */
+/*  goal's units along the direction of travel, so a move that ends short    */
+/*  has a negative final_error.                                              */
+/*                                                                           */
+/*    build/bench-Skills [--only primitive] [--start x,y,heading] [--sd dir] */
+/*                       [--set parameter=value ...]                         */
+/*---------------------------------------------------------------------------*/
+
+extern "C" int programMain();
+
+// The primitives, where the program has them. AutonSelector's forward and
+// turn return its StepOutcome, which is an int.
+void forward(double distanceIn, double maxVelocity) __attribute__((weak));
+void turn(double distanceIn, double maxVelocity) __attribute__((weak));
+int forward(double distanceIn, double maxVelocity, double minimum,
+            uint32_t deadlineMs) __attribute__((weak));
+int turn(double degrees, double maxVelocity, uint32_t deadlineMs)
+    __attribute__((weak));
+void turnR(int tdistance, int tspeed, int twait) __attribute__((weak));
+void gyroL(int tdistance, int tspeed, int twait) __attribute__((weak));
+int sonarmove(int sdistance, int sspeed) __attribute__((weak));
+void stopH() __attribute__((weak));
+
+// Each overload on its own, to tell which ones the program has
+typedef void (*ForwardFunction)(double, double);
+typedef void (*TurnFunction)(double, double);
+typedef int (*StepForwardFunction)(double, double, double, uint32_t);
+typedef int (*StepTurnFunction)(double, double, uint32_t);
+
+enum Primitive {
+  forwardMove,
+  turnMove,
+  stepForwardMove,
+  stepTurnMove,
+  turnRMove,
+  gyroLMove,
+  sonarMove
+};
+
+struct Grid {
+  Primitive primitive;
+  const char *name;
+  const char *units; // of the goal and the errors
+  double tolerance;
+  double arguments[8]; // ends at 0
+  int speeds[4];       // ends at 0, pct for forward and turn, rpm otherwise
+};
+
+static const Grid grids[] = {
+    {forwardMove, "forward", "in", 0.5, {6, 12, 24, 48, -12, -24},
+     {40, 70, 100}},
+    {turnMove, "turn", "deg", 1, {90, 180, 275, 360, -275}, {40, 70, 100}},
+    {stepForwardMove, "forward", "in", 0.5, {6, 12, 24, 48, -12, -24},
+     {40, 70, 100}},
+    {stepTurnMove, "turn", "deg", 1, {90, 180, 275, 360, -275}, {40, 70, 100}},
+    {turnRMove, "turnR", "deg", 1, {100, 200, 300, 400}, {50, 100, 150}},
+    {gyroLMove, "gyroL", "deg", 1, {-30, -45, -90, -135}, {50, 100, 150}},
+    {sonarMove, "sonarmove", "in", 0.5, {24, 36, 48, 84}, {10, 30, 60}},
+};
+
+static const int gridCount = sizeof(grids) / sizeof(Grid);
+
+static const uint32_t restMs = 250;      // before the move
+static const uint32_t timeoutMs = 15000; // for the call to return
+static const uint32_t watchMs = 1000;    // after it returns
+static const int maxSamples = 20000;
+
+// The minimum speed AutonSelector's forward starts from, as its routines
+// mostly have it
+static const double stepMinimum = 50;
+
+static bool available(Primitive primitive) {
+  switch (primitive) {
+  case forwardMove:
+    return (ForwardFunction)forward != NULL;
+  case turnMove:
+    return (TurnFunction)turn != NULL;
+  case stepForwardMove:
+    return (StepForwardFunction)forward != NULL;
+  case stepTurnMove:
+    return (StepTurnFunction)turn != NULL;
+  case turnRMove:
+    return turnR != NULL;
+  case gyroLMove:
+    return gyroL != NULL;
+  case sonarMove:
+    return sonarmove != NULL;
+  }
+  return false;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                One move                                   */
+/*---------------------------------------------------------------------------*/
+
+enum Stage { settingUp, resting, moving, watching };
+
+static const Grid *grid;
+static double argument;
+static int speed;
+
+static int mainTask;
+static bool mainReturned;
+static Stage stage;
+static sim::Pose startPose;
+static double startedAt, returnedAt;
+static double goal, from;
+
+static double sampleTimes[maxSamples];
+static double sampleValues[maxSamples];
+static int sampleCount;
+
+static int runMain() {
+  programMain();
+  mainReturned = true;
+  return 0;
+}
+
+// Lock held. Where the move has got to, in the goal's units
+static double measure() {
+  sim::Pose at = sim::pose();
+  switch (grid->primitive) {
+  case forwardMove:
+  case stepForwardMove: {
+    double h = startPose.heading * M_PI / 180;
+    return (at.x - startPose.x) * sin(h) + (at.y - startPose.y) * cos(h);
+  }
+  case sonarMove:
+    return sim::sonarInches();
+  default:
+    return at.heading - startPose.heading;
+  }
+}
+
+// Lock held. Where the primitive is trying to get to, in the same units
+static double goalFor(double argument) {
+  // wheel degrees to heading degrees for a skid turn in place
+  double turnRatio = sim::robot.wheelDiameter / sim::robot.trackWidth;
+  switch (grid->primitive) {
+  case forwardMove:
+  case stepForwardMove:
+  case gyroLMove:
+  case sonarMove:
+    return argument;
+  case turnMove:
+  case stepTurnMove:
+  case turnRMove:
+    return argument * turnRatio;
+  }
+  return argument;
+}
+
+static int runMove() {
+  sim::sleepMs(restMs);
+  uint32_t deadline;
+  {
+    sim::Guard guard;
+    startPose = sim::pose();
+    from = measure();
+    goal = goalFor(argument);
+    startedAt = sim::now();
+    deadline = (uint32_t)startedAt + timeoutMs;
+    stage = moving;
+  }
+
+  switch (grid->primitive) {
+  case forwardMove:
+    forward(argument, speed);
+    if (stopH != NULL)
+      stopH();
+    break;
+  case turnMove:
+    turn(argument, speed);
+    break;
+  case stepForwardMove:
+    forward(argument, speed, stepMinimum, deadline);
+    if (stopH != NULL)
+      stopH();
+    break;
+  case stepTurnMove:
+    turn(argument, speed, deadline);
+    break;
+  case turnRMove:
+    turnR((int)argument, speed, 0);
+    break;
+  case gyroLMove:
+    gyroL((int)argument, speed, 0);
+    break;
+  case sonarMove:
+    sonarmove((int)argument, speed);
+    break;
+  }
+
+  {
+    sim::Guard guard;
+    returnedAt = sim::now();
+    stage = watching;
+  }
+  sim::sleepMs(watchMs);
+  return 0;
+}
+
+// Lock held
+static bool driveCommanded() {
+  const sim::Robot &r = sim::robot;
+  int drive[] = {r.leftDrive[0], r.leftDrive[1], r.rightDrive[0],
+                 r.rightDrive[1]};
+  for (int i = 0; i < 4; i++) {
+    sim::MotorMode mode = sim::motors[drive[i]].mode;
+    if (mode == sim::motorVelocity || mode == sim::motorPosition)
+      return true;
+  }
+  return false;
+}
+
+// Lock held
+static void brakeDrive() {
+  const sim::Robot &r = sim::robot;
+  int drive[] = {r.leftDrive[0], r.leftDrive[1], r.rightDrive[0],
+                 r.rightDrive[1]};
+  for (int i = 0; i < 4; i++)
+    sim::motors[drive[i]].mode = sim::motorBraking;
+}
+
+static bool watch(double time) {
+  if (stage == settingUp && (mainReturned || driveCommanded())) {
+    sim::stopTask(mainTask);
+    sim::stopPeriod();
+    brakeDrive();
+    sim::startTask(runMove, 7);
+    stage = resting;
+  }
+  if (stage < moving)
+    return true;
+
+  if (sampleCount < maxSamples) {
+    sampleTimes[sampleCount] = time - startedAt;
+    sampleValues[sampleCount] = measure();
+    sampleCount++;
+  }
+  if (stage == moving)
+    return time - startedAt < timeoutMs;
+  return time - returnedAt < watchMs;
+}
+
+static void report(const char *program) {
+  double direction = goal >= from ? 1 : -1;
+  double tolerance = grid->tolerance;
+  double ended = sampleCount > 0 ? sampleValues[sampleCount - 1] : from;
+
+  double reached = -1, settled = 0, overshoot = 0;
+  for (int i = 0; i < sampleCount; i++) {
+    double past = direction * (sampleValues[i] - goal);
+    if (reached < 0 && past >= -tolerance)
+      reached = sampleTimes[i];
+    if (past > overshoot)
+      overshoot = past;
+    if (fabs(sampleValues[i] - ended) > tolerance)
+      settled = i + 1 < sampleCount ? sampleTimes[i + 1] : -1;
+  }
+  // a move still going when it timed out has not settled anywhere
+  double returned = -1;
+  if (stage == watching)
+    returned = returnedAt - startedAt;
+  else
+    settled = -1;
+
+  printf("%s,%s,%g,%d,%.2f,%s,%.0f,%.0f,%.0f,%.2f,%.2f\n", program,
+         grid->name, argument, speed, goal, grid->units, returned, reached,
+         settled, overshoot, direction * (ended - goal));
+}
+
+// In the child: one fresh run of the program
+static void runCase(const char *program, const sim::Options &options) {
+  sim::start(options);
+  mainTask = sim::startTask(runMain, 7);
+  sim::run(watch);
+  sim::Guard guard;
+  report(program);
+  fflush(stdout);
+  _exit(0);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                  Runner                                   */
+/*---------------------------------------------------------------------------*/
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--only primitive] [--start x,y,heading] [--sd dir]\n"
+          "          [--set parameter=value ...]\n",
+          name);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start.x = 72;
+  options.start.y = 72;
+  options.start.heading = 0;
+  options.sdDirectory = "sd";
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+  const char *only = NULL;
+
+  for (int i = 1; i < argc; i += 2) {
+    const char *option = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (value == NULL)
+      usage(argv[0]);
+    if (strcmp(option, "--only") == 0) {
+      only = value;
+    } else if (strcmp(option, "--start") == 0) {
+      if (sscanf(value, "%lf,%lf,%lf", &options.start.x, &options.start.y,
+                 &options.start.heading) != 3)
+        usage(argv[0]);
+    } else if (strcmp(option, "--sd") == 0) {
+      options.sdDirectory = value;
+    } else if (strcmp(option, "--set") == 0) {
+      char name[64];
+      double number;
+      if (sscanf(value, "%63[^=]=%lf", name, &number) != 2 ||
+          !sim::setParameter(name, number))
+        usage(argv[0]);
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  const char *program = strrchr(argv[0], '-');
+  program = program != NULL ? program + 1 : argv[0];
+
+  printf("program,primitive,argument,speed,goal,units,returned_ms,reached_ms,"
+         "settled_ms,overshoot,final_error\n");
+  fflush(stdout);
+
+  int failures = 0, benchmarked = 0;
+  for (int g = 0; g < gridCount; g++) {
+    grid = &grids[g];
+    if (!available(grid->primitive) ||
+        (only != NULL && strcmp(only, grid->name) != 0))
+      continue;
+    benchmarked++;
+    for (int a = 0; grid->arguments[a] != 0; a++) {
+      for (int s = 0; grid->speeds[s] != 0; s++) {
+        argument = grid->arguments[a];
+        speed = grid->speeds[s];
+        pid_t child = fork();
+        if (child == 0)
+          runCase(program, options);
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (child < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+          fprintf(stderr, "%s %g at %d failed\n", grid->name, argument, speed);
+          failures++;
+        }
+      }
+    }
+  }
+  if (benchmarked == 0)
+    fprintf(stderr, "%s: no motion primitives to benchmark%s%s\n", program,
+            only != NULL ? " called " : "", only != NULL ? only : "");
+  return failures > 0 ? 1 : 0;
+}
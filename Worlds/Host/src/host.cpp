@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "steps.h"
+
+/*---------------------------------------------------------------------------*/
+/*                               Host Runner                                 */
+/*                                                                           */
+/*  Runs one program for one period and says where the robot ended up. The   */
+/*  program's main is built as programMain and started as the first task.    */
+/*  Time is simulated, so a whole period takes a fraction of a second and    */
+/*  the same options always give the same run.                               */
+/*                                                                           */
+/*    build/RedFrontPark [--period auton|skills|driver] [--time ms]          */
+/*                       [--start x,y,heading] [--sd dir] [--screen]         */
+/*                       [--trace file.csv] [--every ms]                     */
+/*                       [--steps file.csv] [--expect file.csv]              */
+/*                       [--select mask] [--set parameter=value ...]         */
+/*                                                                           */
+/*  --set changes a number in sim::Robot, e.g. --set batteryCharge=0.4.      */
+/*  --select holds down the buttons of a program's on-screen selector, bit i */
+/*  for button i, so AutonSelector can be run with any routine picked.       */
+/*  The last line printed is the end state as name=value pairs.              */
+/*                                                                           */
+/*  A step ends each time the drive comes to rest. --steps writes where the  */
+/*  robot and its mechanisms were at the end of each step and of the run,    */
+/*  and --expect checks them against a file written that way, within the     */
+/*  tolerances in steps.h, and fails the run if they differ.                 */
+/*---------------------------------------------------------------------------*/
+
+// main keeps its unmangled name when objcopy renames it
+extern "C" int programMain();
+
+static int runProgram() { return programMain(); }
+
+static const uint32_t periodLengths[] = {15000, 105000, 60000};
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--period auton|skills|driver] [--time ms]\n"
+          "          [--start x,y,heading] [--sd dir] [--screen]\n"
+          "          [--trace file.csv] [--every ms]\n"
+          "          [--steps file.csv] [--expect file.csv]\n"
+          "          [--select mask] [--set parameter=value ...]\n"
+          "parameters:",
+          name);
+  for (int i = 0; i < sim::parameterCount; i++)
+    fprintf(stderr, " %s", sim::parameters[i].name);
+  fprintf(stderr, "\n");
+  exit(2);
+}
+
+static sim::Options readOptions(int argc, char **argv) {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 0;
+  options.start.x = 72;
+  options.start.y = 12;
+  options.start.heading = 0;
+  options.sdDirectory = "sd";
+  options.tracePath = NULL;
+  options.traceEveryMs = 10;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  for (int i = 1; i < argc; i++) {
+    const char *option = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(option, "--screen") == 0) {
+      options.echoScreen = true;
+      continue;
+    }
+    if (value == NULL)
+      usage(argv[0]);
+    i++;
+
+    if (strcmp(option, "--period") == 0) {
+      if (strcmp(value, "auton") == 0)
+        options.period = sim::autonomousPeriod;
+      else if (strcmp(value, "driver") == 0)
+        options.period = sim::driverPeriod;
+      else if (strcmp(value, "skills") == 0)
+        options.period = sim::skillsPeriod;
+      else
+        usage(argv[0]);
+    } else if (strcmp(option, "--time") == 0) {
+      options.periodMs = (uint32_t)atol(value);
+    } else if (strcmp(option, "--start") == 0) {
+      if (sscanf(value, "%lf,%lf,%lf", &options.start.x, &options.start.y,
+                 &options.start.heading) != 3)
+        usage(argv[0]);
+    } else if (strcmp(option, "--sd") == 0) {
+      options.sdDirectory = value;
+    } else if (strcmp(option, "--trace") == 0) {
+      options.tracePath = value;
+    } else if (strcmp(option, "--every") == 0) {
+      options.traceEveryMs = (uint32_t)atol(value);
+    } else if (strcmp(option, "--steps") == 0) {
+      options.stepsPath = value;
+    } else if (strcmp(option, "--expect") == 0) {
+      options.expectPath = value;
+    } else if (strcmp(option, "--select") == 0) {
+      options.selectorMask = atoi(value);
+    } else if (strcmp(option, "--set") == 0) {
+      char name[64];
+      double number;
+      if (sscanf(value, "%63[^=]=%lf", name, &number) != 2 ||
+          !sim::setParameter(name, number))
+        usage(argv[0]);
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  if (options.periodMs == 0)
+    options.periodMs = periodLengths[options.period];
+  if (options.traceEveryMs == 0)
+    options.traceEveryMs = 1;
+  return options;
+}
+
+static void traceHeader(FILE *trace) {
+  fprintf(trace, "time_ms,x_in,y_in,heading_deg,left_rpm,right_rpm,"
+                 "flywheel_rpm,intake_rpm,arm_revs\n");
+}
+
+// Lock held
+static void traceRow(FILE *trace, double time) {
+  const sim::Robot &r = sim::robot;
+  sim::Pose at = sim::pose();
+  fprintf(trace, "%.0f,%.2f,%.2f,%.2f,%.1f,%.1f,%.1f,%.1f,%.4f\n", time, at.x,
+          at.y, at.heading,
+          (sim::motors[r.leftDrive[0]].rpm + sim::motors[r.leftDrive[1]].rpm) /
+              2,
+          (sim::motors[r.rightDrive[0]].rpm +
+           sim::motors[r.rightDrive[1]].rpm) /
+              2,
+          sim::motors[r.flywheel[0]].rpm, sim::motors[r.intake].rpm,
+          sim::motors[r.arm].revs);
+}
+
+// Compares the steps and the end with the expected ones, saying what differs
+static bool expectSteps(const char *path, const sim::Step &end) {
+  static sim::Step expected[sim::maxSteps + 1];
+  int count = sim::readSteps(path, expected, sim::maxSteps + 1);
+  if (count < 1)
+    return false;
+
+  bool same = true;
+  int made = sim::stepCount();
+  if (count - 1 != made) {
+    printf("%d steps, expected %d\n", made, count - 1);
+    same = false;
+  }
+  for (int i = 0; i < made && i < count - 1; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "%d", i + 1);
+    same &= sim::sameStep(name, sim::step(i), expected[i], 1, true);
+  }
+  same &= sim::sameStep("end", end, expected[count - 1], 1, true);
+  return same;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                   Run                                     */
+/*---------------------------------------------------------------------------*/
+
+static FILE *trace;
+static double nextRow;
+static uint32_t traceEveryMs;
+
+static bool watch(double time) {
+  if (trace != NULL && time >= nextRow) {
+    traceRow(trace, time);
+    nextRow += traceEveryMs;
+  }
+  sim::watchSteps(time);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  sim::Options options = readOptions(argc, argv);
+  if (options.tracePath != NULL) {
+    trace = fopen(options.tracePath, "w");
+    if (trace == NULL) {
+      perror(options.tracePath);
+      return 1;
+    }
+    traceHeader(trace);
+    traceEveryMs = options.traceEveryMs;
+  }
+
+  sim::start(options);
+  sim::startTask(runProgram, 7);
+  sim::run(watch);
+
+  sim::Guard guard;
+  if (trace != NULL) {
+    traceRow(trace, sim::now());
+    fclose(trace);
+  }
+  const sim::Robot &r = sim::robot;
+  sim::Pose at = sim::pose();
+  printf("time_ms=%.0f x=%.2f y=%.2f heading=%.2f left_revs=%.3f "
+         "right_revs=%.3f flywheel_rpm=%.1f intake_rpm=%.1f arm_revs=%.4f\n",
+         sim::now(), at.x, at.y, at.heading, sim::motors[r.leftDrive[0]].revs,
+         sim::motors[r.rightDrive[0]].revs, sim::motors[r.flywheel[0]].rpm,
+         sim::motors[r.intake].rpm, sim::motors[r.arm].revs);
+
+  int status = 0;
+  sim::Step end = sim::snapshot(sim::now());
+  if (options.stepsPath != NULL && !sim::writeSteps(options.stepsPath, end))
+    status = 1;
+  if (options.expectPath != NULL && !expectSteps(options.expectPath, end))
+    status = 1;
+  fflush(stdout);
+
+  // the program's tasks are left suspended, so leave without unwinding them
+  _exit(status);
+}
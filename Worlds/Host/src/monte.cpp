@@ -0,0 +1,378 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "steps.h"
+
+/*---------------------------------------------------------------------------*/
+/*                              Monte-Carlo Runner                           */
+/*                                                                           */
+/*  Runs one program many times with the robot and its start varied, and     */
+/*  says how often each step still ends where the expected run's does and    */
+/*  how long it takes. Each run varies every parameter in the vary table     */
+/*  uniformly between its limits, moves the start by a normal error and      */
+/*  gets its own sensor noise. Run n uses seed + n, so any run can be had    */
+/*  again, and the runs are forked across the cores.                         */
+/*                                                                           */
+/*    build/monte-Skills [--runs n] [--jobs n] [--seed n] [--slack factor]   */
+/*                       [--period auton|skills|driver] [--time ms]          */
+/*                       [--start x,y,heading] [--start-error in,deg]        */
+/*                       [--sd dir] [--expect file.csv] [--select mask]      */
+/*                       [--vary parameter=low,high ...]                     */
+/*                       [--set parameter=value ...]                         */
+/*                                                                           */
+/*  A step is ok when it is within slack times the step tolerances of the    */
+/*  expected one, 3 unless given, so 3 in and 6 deg, and a run succeeds      */
+/*  when all its steps and its end are ok.                                   */
+/*  The CSV has a row per expected step, one for the end and one for the     */
+/*  whole run; durations are from the step before, or the start.             */
+/*---------------------------------------------------------------------------*/
+
+extern "C" int programMain();
+
+static int runProgram() { return programMain(); }
+
+static const uint32_t periodLengths[] = {15000, 105000, 60000};
+
+struct Vary {
+  const char *name;
+  double low, high;
+};
+
+static const int maxVaries = 64;
+
+// What changes between venues, batteries and fields
+static Vary varies[maxVaries] = {
+    {"grip", 0.7, 1},
+    {"sideGrip", 0.4, 0.6},
+    {"gripBalance", -0.05, 0.05},
+    {"batteryCharge", 0.2, 1},
+    {"batteryResistance", 0.1, 0.25},
+    {"gyroNoise", 0.2, 0.2},
+    {"gyroDrift", -0.05, 0.05},
+    {"sonarNoise", 0.3, 0.3},
+};
+static int varyCount = 8;
+
+static double startErrorIn = 0.5;
+static double startErrorDeg = 1;
+
+// What a run sends back to the runner
+struct Outcome {
+  int steps;    // made, the end not counted
+  bool matched; // every step and the end ok, and as many steps as expected
+  double time[sim::maxSteps + 1]; // when each step ended, then the run
+  bool ok[sim::maxSteps + 1];     // against the expected step, then the end
+};
+
+static sim::Step expected[sim::maxSteps + 1];
+static int expectedSteps; // the end not counted
+
+/*---------------------------------------------------------------------------*/
+/*                                 One run                                   */
+/*---------------------------------------------------------------------------*/
+
+static bool watch(double time) {
+  sim::watchSteps(time);
+  return true;
+}
+
+static void vary(sim::Options &options) {
+  for (int i = 0; i < varyCount; i++) {
+    const Vary &v = varies[i];
+    sim::setParameter(v.name, v.low + (v.high - v.low) * sim::random());
+  }
+  options.start.x += sim::noise(startErrorIn);
+  options.start.y += sim::noise(startErrorIn);
+  options.start.heading += sim::noise(startErrorDeg);
+}
+
+// In the child: one run, written to out
+static void runOnce(sim::Options options, uint32_t seed, double slack,
+                    int out) {
+  sim::seedRandom(seed);
+  vary(options);
+  sim::start(options);
+  sim::startTask(runProgram, 7);
+  sim::run(watch);
+
+  sim::Guard guard;
+  static Outcome outcome;
+  outcome.steps = sim::stepCount();
+  outcome.matched = outcome.steps == expectedSteps;
+  for (int i = 0; i < outcome.steps; i++) {
+    outcome.time[i] = sim::step(i).time;
+    outcome.ok[i] = i < expectedSteps &&
+                    sim::sameStep("", sim::step(i), expected[i], slack, false);
+    outcome.matched &= outcome.ok[i];
+  }
+  sim::Step end = sim::snapshot(sim::now());
+  outcome.time[outcome.steps] = end.time;
+  outcome.ok[outcome.steps] =
+      sim::sameStep("", end, expected[expectedSteps], slack, false);
+  outcome.matched &= outcome.ok[outcome.steps];
+
+  ssize_t written = write(out, &outcome, sizeof(outcome));
+  _exit(written == (ssize_t)sizeof(outcome) ? 0 : 1);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                 Summary                                   */
+/*---------------------------------------------------------------------------*/
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+// Prints one row from the ok flags, end times and durations of the runs
+// that got this far
+static void summarize(const char *step, double expectedEnd, int runs, int ok,
+                      double *ends, double *durations, int count) {
+  double endSum = 0, sum = 0, squares = 0;
+  for (int i = 0; i < count; i++) {
+    endSum += ends[i];
+    sum += durations[i];
+    squares += durations[i] * durations[i];
+  }
+  double mean = count > 0 ? sum / count : 0;
+  double sd = count > 1 ? sqrt((squares - sum * mean) / (count - 1)) : 0;
+
+  qsort(durations, count, sizeof(double), compareDoubles);
+  double p[3] = {0, 0, 0};
+  const double at[3] = {0.05, 0.5, 0.95};
+  for (int i = 0; i < 3 && count > 0; i++)
+    p[i] = durations[(int)(at[i] * (count - 1) + 0.5)];
+
+  printf("%s,%d,%.3f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f\n", step, runs,
+         (double)ok / runs, expectedEnd, count > 0 ? endSum / count : 0, mean,
+         sd, p[0], p[1], p[2]);
+}
+
+static void report(const Outcome *outcomes, int runs) {
+  double *ends = (double *)malloc(runs * sizeof(double));
+  double *durations = (double *)malloc(runs * sizeof(double));
+  printf("step,runs,ok_rate,expected_end_ms,mean_end_ms,mean_ms,sd_ms,p5_ms,"
+         "p50_ms,p95_ms\n");
+
+  for (int s = 0; s <= expectedSteps; s++) {
+    bool isEnd = s == expectedSteps;
+    int ok = 0, count = 0;
+    for (int r = 0; r < runs; r++) {
+      const Outcome &o = outcomes[r];
+      // the end is the run's last entry however many steps it made
+      int i = isEnd ? o.steps : s;
+      if (!isEnd && i >= o.steps)
+        continue;
+      ok += o.ok[i];
+      ends[count] = o.time[i];
+      durations[count] = o.time[i] - (i > 0 ? o.time[i - 1] : 0);
+      count++;
+    }
+    char name[16];
+    if (isEnd)
+      snprintf(name, sizeof(name), "end");
+    else
+      snprintf(name, sizeof(name), "%d", s + 1);
+    summarize(name, expected[s].time, runs, ok, ends, durations, count);
+  }
+
+  int matched = 0;
+  for (int r = 0; r < runs; r++) {
+    matched += outcomes[r].matched;
+    ends[r] = durations[r] = outcomes[r].time[outcomes[r].steps];
+  }
+  summarize("run", expected[expectedSteps].time, runs, matched, ends,
+            durations, runs);
+  free(ends);
+  free(durations);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                  Runner                                   */
+/*---------------------------------------------------------------------------*/
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--runs n] [--jobs n] [--seed n] [--slack factor]\n"
+          "          [--period auton|skills|driver] [--time ms]\n"
+          "          [--start x,y,heading] [--start-error in,deg]\n"
+          "          [--sd dir] [--expect file.csv] [--select mask]\n"
+          "          [--vary parameter=low,high ...]\n"
+          "          [--set parameter=value ...]\n",
+          name);
+  exit(2);
+}
+
+static bool isParameter(const char *name) {
+  for (int i = 0; i < sim::parameterCount; i++) {
+    if (strcmp(sim::parameters[i].name, name) == 0)
+      return true;
+  }
+  return false;
+}
+
+// A set parameter is one that varies between equal limits
+static void setVary(const char *name, double low, double high) {
+  for (int i = 0; i < varyCount; i++) {
+    if (strcmp(varies[i].name, name) == 0) {
+      varies[i].low = low;
+      varies[i].high = high;
+      return;
+    }
+  }
+  if (varyCount < maxVaries) {
+    Vary &v = varies[varyCount++];
+    v.name = strdup(name);
+    v.low = low;
+    v.high = high;
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *program = strrchr(argv[0], '-');
+  program = program != NULL ? program + 1 : argv[0];
+
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 0;
+  options.start.x = 72;
+  options.start.y = 12;
+  options.start.heading = 0;
+  options.sdDirectory = "sd";
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  int runs = 200;
+  int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t seed = 1;
+  double slack = 3;
+  char expectPath[256];
+  snprintf(expectPath, sizeof(expectPath), "expected/%s.csv", program);
+  options.expectPath = expectPath;
+
+  for (int i = 1; i < argc; i += 2) {
+    const char *option = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (value == NULL)
+      usage(argv[0]);
+    if (strcmp(option, "--runs") == 0) {
+      runs = atoi(value);
+    } else if (strcmp(option, "--jobs") == 0) {
+      jobs = atoi(value);
+    } else if (strcmp(option, "--seed") == 0) {
+      seed = (uint32_t)atol(value);
+    } else if (strcmp(option, "--slack") == 0) {
+      slack = atof(value);
+    } else if (strcmp(option, "--period") == 0) {
+      if (strcmp(value, "auton") == 0)
+        options.period = sim::autonomousPeriod;
+      else if (strcmp(value, "driver") == 0)
+        options.period = sim::driverPeriod;
+      else if (strcmp(value, "skills") == 0)
+        options.period = sim::skillsPeriod;
+      else
+        usage(argv[0]);
+    } else if (strcmp(option, "--time") == 0) {
+      options.periodMs = (uint32_t)atol(value);
+    } else if (strcmp(option, "--start") == 0) {
+      if (sscanf(value, "%lf,%lf,%lf", &options.start.x, &options.start.y,
+                 &options.start.heading) != 3)
+        usage(argv[0]);
+    } else if (strcmp(option, "--start-error") == 0) {
+      if (sscanf(value, "%lf,%lf", &startErrorIn, &startErrorDeg) != 2)
+        usage(argv[0]);
+    } else if (strcmp(option, "--sd") == 0) {
+      options.sdDirectory = value;
+    } else if (strcmp(option, "--expect") == 0) {
+      options.expectPath = value;
+    } else if (strcmp(option, "--select") == 0) {
+      options.selectorMask = atoi(value);
+    } else if (strcmp(option, "--vary") == 0) {
+      char name[64];
+      double low, high;
+      if (sscanf(value, "%63[^=]=%lf,%lf", name, &low, &high) != 3 ||
+          !isParameter(name))
+        usage(argv[0]);
+      setVary(name, low, high);
+    } else if (strcmp(option, "--set") == 0) {
+      char name[64];
+      double number;
+      if (sscanf(value, "%63[^=]=%lf", name, &number) != 2 ||
+          !isParameter(name))
+        usage(argv[0]);
+      setVary(name, number, number);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (runs < 1 || jobs < 1)
+    usage(argv[0]);
+  if (options.periodMs == 0)
+    options.periodMs = periodLengths[options.period];
+
+  int count = sim::readSteps(options.expectPath, expected, sim::maxSteps + 1);
+  if (count < 1) {
+    fprintf(stderr, "%s: no expected steps\n", options.expectPath);
+    return 1;
+  }
+  expectedSteps = count - 1;
+
+  Outcome *outcomes = (Outcome *)calloc(runs, sizeof(Outcome));
+  pid_t *children = (pid_t *)calloc(runs, sizeof(pid_t));
+  int *pipes = (int *)calloc(runs, sizeof(int));
+  int started = 0, finished = 0, failures = 0;
+  fflush(stdout);
+
+  while (finished < runs) {
+    if (started < runs && started - finished < jobs) {
+      int ends[2];
+      if (pipe(ends) != 0) {
+        perror("pipe");
+        return 1;
+      }
+      pid_t child = fork();
+      if (child < 0) {
+        perror("fork");
+        return 1;
+      }
+      if (child == 0) {
+        close(ends[0]);
+        runOnce(options, seed + started, slack, ends[1]);
+      }
+      close(ends[1]);
+      children[started] = child;
+      pipes[started] = ends[0];
+      started++;
+      continue;
+    }
+
+    int status = 0;
+    pid_t child = wait(&status);
+    int run = 0;
+    while (run < started && children[run] != child)
+      run++;
+    if (run == started)
+      continue;
+    ssize_t got = read(pipes[run], &outcomes[run], sizeof(Outcome));
+    close(pipes[run]);
+    if (got != (ssize_t)sizeof(Outcome) || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "run %d (seed %u) failed\n", run, seed + run);
+      memset(&outcomes[run], 0, sizeof(Outcome));
+      failures++;
+    }
+    finished++;
+  }
+
+  report(outcomes, runs);
+  return failures > 0 ? 1 : 0;
+}
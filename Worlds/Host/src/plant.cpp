@@ -0,0 +1,411 @@
+#include <math.h>
+#include <string.h>
+
+#include "sim.h"
+
+/*---------------------------------------------------------------------------*/
+/*                                  Plant                                    */
+/*                                                                           */
+/*  The robot as physics, stepped at 1 kHz. Each V5 motor is a DC motor      */
+/*  behind its own controller: the controller turns the mode and target      */
+/*  into a voltage, the battery caps it, back EMF and the 2.5 A current      */
+/*  limit turn it into torque. Brake shorts the windings, coast opens them   */
+/*  and hold servos on the position the motor stopped at.                    */
+/*                                                                           */
+/*  The chassis is a rigid body on four wheels. Each wheel is driven by its  */
+/*  motor and grips the tiles through a friction force that grows with slip  */
+/*  until it saturates, along the wheel and across it, so the robot skids to */
+/*  turn and can spin its wheels or be pushed sideways. Tire contact is much */
+/*  stiffer than anything else, so it is substepped inside each step.        */
+/*                                                                           */
+/*  Everything in here is SI: metres, seconds, radians, newtons.             */
+/*---------------------------------------------------------------------------*/
+
+namespace sim {
+
+Robot robot = {
+    {2, 10}, // lf on PORT3, lb on PORT11
+    {8, 19}, // rf on PORT9, rb on PORT20
+    {0, 1},  // fw, fw2
+    9,       // in
+    18,      // arm
+
+    6.8,   // mass
+    4,     // wheelDiameter
+    12.5,  // trackWidth
+    11,    // wheelBase
+    18,    // length
+    17,    // width
+    0.9,   // grip
+    0.5,   // sideGrip
+    0,     // gripBalance
+    0.08,  // slipSpeed
+    0.06,  // rolling
+    0.002, // wheelInertia
+
+    0.01,   // flywheelInertia
+    0.0005, // intakeInertia
+    0.02,   // armInertia
+    0.8,    // armGravity
+    -0.05,  // armLowest
+    0.5,    // armHighest
+
+    1,    // batteryCharge
+    0.12, // batteryResistance
+
+    0, // gyroNoise
+    0, // gyroDrift
+    0, // sonarNoise
+};
+
+#define PARAMETER(name) {#name, &robot.name}
+
+const Parameter parameters[] = {
+    PARAMETER(mass),
+    PARAMETER(wheelDiameter),
+    PARAMETER(trackWidth),
+    PARAMETER(wheelBase),
+    PARAMETER(length),
+    PARAMETER(width),
+    PARAMETER(grip),
+    PARAMETER(sideGrip),
+    PARAMETER(gripBalance),
+    PARAMETER(slipSpeed),
+    PARAMETER(rolling),
+    PARAMETER(wheelInertia),
+    PARAMETER(flywheelInertia),
+    PARAMETER(intakeInertia),
+    PARAMETER(armInertia),
+    PARAMETER(armGravity),
+    PARAMETER(armLowest),
+    PARAMETER(armHighest),
+    PARAMETER(batteryCharge),
+    PARAMETER(batteryResistance),
+    PARAMETER(gyroNoise),
+    PARAMETER(gyroDrift),
+    PARAMETER(sonarNoise),
+};
+
+const int parameterCount = sizeof(parameters) / sizeof(Parameter);
+
+bool setParameter(const char *name, double value) {
+  for (int i = 0; i < parameterCount; i++) {
+    if (strcmp(parameters[i].name, name) == 0) {
+      *parameters[i].value = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+const double inch = 0.0254;
+const double gravity = 9.81;
+const double turn = 2 * M_PI;
+
+// V5 smart motor, at the output shaft of whichever cartridge is fitted
+const double nominalVolts = 12.8;
+const double currentLimit = 2.5;   // amps
+const double rawStallAmps = 4.0;   // what the windings would draw unlimited
+const double stallTorque100 = 2.1; // Nm at the current limit on 36:1
+const double freeSpeedRatio = 1.2; // free speed over the rated rpm
+const double frictionRatio = 0.1;  // gearbox friction over stall torque
+const double batteryAmpHours = 1.1;
+
+// The motor's own controller
+const double velocityGain = 4;   // volts per volt of speed error
+const double integralGain = 20;  // per second
+const double positionGain = 12;  // rad/s per rad of error on a move
+const double holdGain = 25;      // rad/s per rad of error on a hold
+const double moveTolerance = turn / 360;
+const int contactSubsteps = 8;
+
+struct Body {
+  double x, y;    // m
+  double heading; // rad, clockwise from +y
+  double vx, vy;  // m/s in the field
+  double spin;    // rad/s, clockwise
+};
+
+static Body body;
+static double omega[portCount];    // rad/s of each output shaft
+static double integral[portCount]; // of the velocity error, rad
+static MotorMode lastMode[portCount];
+static double armAngle; // rad from where it starts
+static double charge;   // of the battery, 0..1
+static double supplyAmps;
+static double batteryVolts;
+static double gyroDrifted; // degrees
+
+void resetPlant(const Pose &start) {
+  body.x = start.x * inch;
+  body.y = start.y * inch;
+  body.heading = start.heading * M_PI / 180;
+  body.vx = body.vy = body.spin = 0;
+  for (int i = 0; i < portCount; i++) {
+    motors[i].revs = motors[i].rpm = motors[i].amps = 0;
+    omega[i] = integral[i] = 0;
+    lastMode[i] = motors[i].mode;
+  }
+  armAngle = 0;
+  charge = robot.batteryCharge;
+  supplyAmps = 0;
+  batteryVolts = nominalVolts;
+  gyroDrifted = 0;
+}
+
+static double clamp(double x, double limit) {
+  return x > limit ? limit : x < -limit ? -limit : x;
+}
+
+static double ratedSpeed(const Motor &m) { return m.maxRpm / 60 * turn; }
+static double freeSpeed(const Motor &m) {
+  return ratedSpeed(m) * freeSpeedRatio;
+}
+static double stallTorque(const Motor &m) {
+  return stallTorque100 * 100 / m.maxRpm;
+}
+
+// Open circuit voltage of the battery from its charge
+static double openVolts(double charge) { return 11.6 + 1.8 * charge; }
+
+// Torque the motor puts on its shaft this step, and the current it draws
+static double motorTorque(int port, double dt) {
+  Motor &m = motors[port];
+  double w = omega[port];
+  if (m.mode != lastMode[port]) {
+    integral[port] = 0;
+    lastMode[port] = m.mode;
+  }
+  if (m.mode == motorCoasting) {
+    m.amps = 0;
+    return 0;
+  }
+
+  double volts = 0;
+  if (m.mode != motorBraking) {
+    double target = 0;
+    double error = (m.targetRevs - m.revs) * turn;
+    if (m.mode == motorVelocity) {
+      target = clamp(m.targetRpm / 60 * turn, ratedSpeed(m));
+    } else if (m.mode == motorPosition) {
+      target = clamp(error * positionGain, m.targetRpm / 60 * turn);
+      if (fabs(error) < moveTolerance)
+        m.moveDone = true;
+    } else {
+      target = clamp(error * holdGain, ratedSpeed(m));
+    }
+
+    double perRadS = nominalVolts / freeSpeed(m);
+    integral[port] = clamp(integral[port] + (target - w) * dt,
+                           freeSpeed(m) / integralGain);
+    volts = perRadS * (target + velocityGain * (target - w) +
+                       integralGain * integral[port]);
+  }
+
+  volts = clamp(volts, batteryVolts);
+  double amps = rawStallAmps * (volts - nominalVolts * w / freeSpeed(m)) /
+                nominalVolts;
+  amps = clamp(amps, currentLimit);
+  m.amps = fabs(amps);
+  if (amps * volts > 0)
+    supplyAmps += amps * volts / batteryVolts;
+  return amps / currentLimit * stallTorque(m);
+}
+
+// Gearbox friction, smoothed through zero so a shaft at rest stays at rest
+static double friction(const Motor &m, double w) {
+  return -frictionRatio * stallTorque(m) * clamp(w / 0.5, 1);
+}
+
+static void spinShaft(int port, double torque, double inertia, double dt) {
+  omega[port] += (torque + friction(motors[port], omega[port])) / inertia * dt;
+}
+
+// Two motors on one flywheel shaft turn together
+static void stepFlywheel(const double *torque, double dt) {
+  int a = robot.flywheel[0], b = robot.flywheel[1];
+  double total = torque[a] + torque[b] + friction(motors[a], omega[a]) +
+                 friction(motors[b], omega[b]);
+  omega[a] += total / robot.flywheelInertia * dt;
+  omega[b] = omega[a];
+}
+
+// The arm hangs from where it starts and sits against its hard stops
+static void stepArm(const double *torque, double dt) {
+  int port = robot.arm;
+  double load = -robot.armGravity * sin(armAngle);
+  spinShaft(port, torque[port] + load, robot.armInertia, dt);
+  armAngle += omega[port] * dt;
+
+  double lowest = robot.armLowest * turn, highest = robot.armHighest * turn;
+  if (armAngle < lowest || armAngle > highest) {
+    armAngle = armAngle < lowest ? lowest : highest;
+    omega[port] = 0;
+  }
+}
+
+struct Wheel {
+  int port;
+  double across, along; // m from the centre, right and forward
+};
+
+// Steps the chassis and its wheels through the tire forces
+static void stepChassis(const double *torque, double dt) {
+  const Wheel wheels[4] = {
+      {robot.leftDrive[0], -robot.trackWidth / 2, robot.wheelBase / 2},
+      {robot.leftDrive[1], -robot.trackWidth / 2, -robot.wheelBase / 2},
+      {robot.rightDrive[0], robot.trackWidth / 2, robot.wheelBase / 2},
+      {robot.rightDrive[1], robot.trackWidth / 2, -robot.wheelBase / 2},
+  };
+  double radius = robot.wheelDiameter / 2 * inch;
+  double load = robot.mass * gravity / 4;
+  double inertia = robot.mass *
+                   (pow(robot.length * inch, 2) + pow(robot.width * inch, 2)) /
+                   12;
+
+  double h = dt / contactSubsteps;
+  for (int step = 0; step < contactSubsteps; step++) {
+    double fx = 0, fy = 0, moment = 0;
+    double forwardX = sin(body.heading), forwardY = cos(body.heading);
+    double rightX = cos(body.heading), rightY = -sin(body.heading);
+
+    for (int i = 0; i < 4; i++) {
+      const Wheel &w = wheels[i];
+      double px = (w.across * rightX + w.along * forwardX) * inch;
+      double py = (w.across * rightY + w.along * forwardY) * inch;
+      double vx = body.vx + body.spin * py;
+      double vy = body.vy - body.spin * px;
+
+      double slip = vx * forwardX + vy * forwardY - omega[w.port] * radius;
+      double skid = vx * rightX + vy * rightY;
+      double grip = robot.grip * (w.across < 0 ? 1 + robot.gripBalance
+                                               : 1 - robot.gripBalance);
+      double along = -grip * load * clamp(slip / robot.slipSpeed, 1);
+      double across =
+          -robot.sideGrip * load * clamp(skid / robot.slipSpeed, 1);
+
+      double wx = along * forwardX + across * rightX;
+      double wy = along * forwardY + across * rightY;
+      fx += wx;
+      fy += wy;
+      moment -= px * wy - py * wx;
+
+      double rolling = robot.rolling * load * radius *
+                       clamp(omega[w.port] * radius / robot.slipSpeed, 1);
+      spinShaft(w.port, torque[w.port] - along * radius - rolling,
+                robot.wheelInertia, h);
+    }
+
+    body.vx += fx / robot.mass * h;
+    body.vy += fy / robot.mass * h;
+    body.spin += moment / inertia * h;
+    body.x += body.vx * h;
+    body.y += body.vy * h;
+    body.heading += body.spin * h;
+  }
+}
+
+// Pushes the robot back inside the field walls and stops it going further in
+static void stepWalls() {
+  double halfLength = robot.length / 2 * inch;
+  double halfWidth = robot.width / 2 * inch;
+  double forwardX = sin(body.heading), forwardY = cos(body.heading);
+  double rightX = cos(body.heading), rightY = -sin(body.heading);
+  double size = fieldSize * inch;
+
+  double lowX = 0, highX = 0, lowY = 0, highY = 0;
+  for (int corner = 0; corner < 4; corner++) {
+    double a = corner & 1 ? halfWidth : -halfWidth;
+    double b = corner & 2 ? halfLength : -halfLength;
+    double x = body.x + a * rightX + b * forwardX;
+    double y = body.y + a * rightY + b * forwardY;
+    lowX = fmin(lowX, x);
+    highX = fmax(highX, x - size);
+    lowY = fmin(lowY, y);
+    highY = fmax(highY, y - size);
+  }
+
+  if (lowX < 0 || highX > 0) {
+    body.x -= lowX + highX;
+    if ((lowX < 0 && body.vx < 0) || (highX > 0 && body.vx > 0))
+      body.vx = 0;
+  }
+  if (lowY < 0 || highY > 0) {
+    body.y -= lowY + highY;
+    if ((lowY < 0 && body.vy < 0) || (highY > 0 && body.vy > 0))
+      body.vy = 0;
+  }
+}
+
+static bool onChassis(int port) {
+  return port == robot.leftDrive[0] || port == robot.leftDrive[1] ||
+         port == robot.rightDrive[0] || port == robot.rightDrive[1];
+}
+
+void stepPlant(double dt) {
+  batteryVolts = openVolts(charge) - robot.batteryResistance * supplyAmps;
+  supplyAmps = 0;
+
+  double torque[portCount];
+  for (int i = 0; i < portCount; i++)
+    torque[i] = motors[i].used ? motorTorque(i, dt) : 0;
+
+  for (int i = 0; i < portCount; i++) {
+    if (!motors[i].used || onChassis(i) || i == robot.flywheel[0] ||
+        i == robot.flywheel[1] || i == robot.arm)
+      continue;
+    spinShaft(i, torque[i], robot.intakeInertia, dt);
+  }
+  stepFlywheel(torque, dt);
+  stepArm(torque, dt);
+  stepChassis(torque, dt);
+  stepWalls();
+
+  for (int i = 0; i < portCount; i++) {
+    motors[i].revs += omega[i] / turn * dt;
+    motors[i].rpm = omega[i] / turn * 60;
+  }
+  charge -= supplyAmps * dt / 3600 / batteryAmpHours;
+  if (charge < 0)
+    charge = 0;
+  gyroDrifted += robot.gyroDrift * dt;
+}
+
+Pose pose() {
+  Pose at;
+  at.x = body.x / inch;
+  at.y = body.y / inch;
+  at.heading = body.heading * 180 / M_PI;
+  return at;
+}
+
+double gyroHeading() {
+  return body.heading * 180 / M_PI + gyroDrifted + noise(robot.gyroNoise);
+}
+
+// The sonar looks straight back from the middle of the rear of the robot
+double sonarInches() {
+  Pose at = pose();
+  double heading = body.heading;
+  double dx = -sin(heading), dy = -cos(heading);
+  double x = at.x + dx * robot.length / 2, y = at.y + dy * robot.length / 2;
+
+  double nearest = 1e9;
+  if (dx > 1e-9)
+    nearest = fmin(nearest, (fieldSize - x) / dx);
+  if (dx < -1e-9)
+    nearest = fmin(nearest, -x / dx);
+  if (dy > 1e-9)
+    nearest = fmin(nearest, (fieldSize - y) / dy);
+  if (dy < -1e-9)
+    nearest = fmin(nearest, -y / dy);
+  nearest += noise(robot.sonarNoise);
+  return nearest < 0 ? 0 : nearest;
+}
+
+// Bare grey tiles everywhere
+int32_t lineReflection() { return 2900; }
+
+double batteryPercent() { return charge * 100; }
+
+} // namespace sim
@@ -0,0 +1,308 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <ucontext.h>
+
+#include "sim.h"
+
+/*---------------------------------------------------------------------------*/
+/*                          Clock, tasks and devices                         */
+/*                                                                           */
+/*  Time is virtual and only moves when the program spends it. Every device  */
+/*  or clock call costs callMicros, so a busy loop advances time the way it  */
+/*  would on the Brain, and a sleep moves its task's wake up time on. The    */
+/*  tasks are coroutines run one at a time by run(): a task keeps the Brain  */
+/*  until it sleeps or yields, or until it makes a call after using up its   */
+/*  slice, and then the next task that is due runs, round robin. Nothing     */
+/*  depends on the wall clock, so every run of the same program with the     */
+/*  same options is the same run, step for step, and takes milliseconds.     */
+/*                                                                           */
+/*  A loop that never calls into vex cannot be switched out of, and hangs.   */
+/*---------------------------------------------------------------------------*/
+
+namespace sim {
+
+Motor motors[portCount];
+
+static Options options;
+
+static const uint64_t callMicros = 10;
+static const uint64_t sliceMicros = 2000;
+
+static uint64_t clockMicros;
+static uint64_t plantMicros;
+
+double now() { return clockMicros / 1000.0; }
+uint64_t nowMicros() { return clockMicros; }
+
+static void catchUp() {
+  while (plantMicros + stepMs * 1000 <= clockMicros) {
+    stepPlant(stepMs / 1000);
+    plantMicros += stepMs * 1000;
+  }
+}
+
+Motor &motor(int port) {
+  return motors[port < 0 || port >= portCount ? 0 : port];
+}
+
+void start(const Options &given) {
+  options = given;
+  if (options.selectorMask >= 0 && !pressSelector(options.selectorMask)) {
+    fprintf(stderr, "the program has no selector to press\n");
+    exit(2);
+  }
+  Guard guard;
+  resetPlant(options.start);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                  Tasks                                    */
+/*---------------------------------------------------------------------------*/
+
+static const int maxTasks = 32;
+static const size_t stackBytes = 1 << 20;
+
+struct Task {
+  bool used;
+  bool done;
+  TaskEntry entry;
+  uint64_t wakeAt;
+  ucontext_t context;
+  char *stack;
+};
+
+static Task tasks[maxTasks];
+static ucontext_t scheduler;
+static int current = -1; // the running task, -1 for run() itself
+static uint64_t sliceEnds;
+
+// Tasks that have not returned yet, main's included
+static int running;
+
+// Back to run(), which picks up the next task that is due
+static void switchOut() {
+  swapcontext(&tasks[current].context, &scheduler);
+}
+
+void lock() {
+  if (current >= 0) {
+    clockMicros += callMicros;
+    if (clockMicros >= sliceEnds)
+      switchOut();
+  }
+  catchUp();
+}
+
+// Nothing to release: a task only gives up the Brain inside lock() or a sleep
+void unlock() {}
+
+static void runTask() {
+  Task &task = tasks[current];
+  task.entry();
+  task.done = true;
+  running--;
+  // returning resumes run() through uc_link
+}
+
+int startTask(TaskEntry entry, int32_t priority) {
+  int slot = 0;
+  while (slot < maxTasks && tasks[slot].used)
+    slot++;
+  if (slot == maxTasks) {
+    fprintf(stderr, "more than %d tasks\n", maxTasks);
+    exit(1);
+  }
+
+  Task &task = tasks[slot];
+  task.used = true;
+  task.done = false;
+  task.entry = entry;
+  task.wakeAt = clockMicros;
+  if (task.stack == NULL)
+    task.stack = (char *)malloc(stackBytes);
+  getcontext(&task.context);
+  task.context.uc_stack.ss_sp = task.stack;
+  task.context.uc_stack.ss_size = stackBytes;
+  task.context.uc_link = &scheduler;
+  makecontext(&task.context, runTask, 0);
+  running++;
+  return slot;
+}
+
+void stopTask(int slot) {
+  if (slot < 0 || slot >= maxTasks || !tasks[slot].used || slot == current)
+    return;
+  tasks[slot].used = false;
+  if (!tasks[slot].done)
+    running--;
+}
+
+void sleepMs(uint32_t ms) {
+  if (current < 0)
+    return;
+  // a yield costs a call, so tasks that only yield still move time on
+  clockMicros += ms == 0 ? callMicros : 0;
+  tasks[current].wakeAt = clockMicros + ms * 1000;
+  switchOut();
+}
+
+void run(bool (*watch)(double time)) {
+  int next = 0;
+  uint64_t watchAt = clockMicros;
+  while (!periodOver()) {
+    int due = -1;
+    uint64_t wakeAt = watchAt;
+    for (int i = 0; i < maxTasks && due < 0; i++) {
+      int slot = (next + i) % maxTasks;
+      if (!tasks[slot].used)
+        continue;
+      if (tasks[slot].wakeAt <= clockMicros)
+        due = slot;
+      else if (tasks[slot].wakeAt < wakeAt)
+        wakeAt = tasks[slot].wakeAt;
+    }
+
+    if (due >= 0) {
+      current = due;
+      sliceEnds = clockMicros + sliceMicros;
+      swapcontext(&scheduler, &tasks[due].context);
+      current = -1;
+      tasks[due].used = !tasks[due].done;
+      next = due + 1;
+    } else if (wakeAt > clockMicros) {
+      // everyone is asleep
+      clockMicros = wakeAt;
+    }
+
+    catchUp();
+    if (clockMicros >= watchAt) {
+      if (!watch(now()))
+        return;
+      watchAt = (clockMicros / 1000 + 1) * 1000;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*                               Competition                                 */
+/*                                                                           */
+/*  A program that registers a callback for the period being run has it      */
+/*  started straight away, and the period lasts from then. One that never    */
+/*  does is timed from the start, and finishes once main and every task it   */
+/*  started have returned.                                                   */
+/*---------------------------------------------------------------------------*/
+
+static void (*periodCallback)(void);
+static double periodStartedAt;
+static bool callbackReturned;
+static int periodTask = -1;
+
+static int runPeriod() {
+  periodCallback();
+  callbackReturned = true;
+  return 0;
+}
+
+void competitionCallback(bool autonomous, void (*callback)(void)) {
+  bool wanted = autonomous ? options.period != driverPeriod
+                           : options.period == driverPeriod;
+  if (!wanted || periodCallback != NULL)
+    return;
+  periodCallback = callback;
+  periodStartedAt = now();
+  periodTask = startTask(runPeriod, 7);
+}
+
+void stopPeriod() {
+  if (periodTask >= 0)
+    stopTask(periodTask);
+}
+
+bool inPeriod(Period period) {
+  return period == options.period && !periodOver();
+}
+
+bool periodOver() {
+  if (now() - periodStartedAt >= options.periodMs)
+    return true;
+  return periodCallback != NULL ? callbackReturned : running == 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                             Random numbers                                */
+/*---------------------------------------------------------------------------*/
+
+// xorshift32, which is plenty for noise and gives the same numbers everywhere
+static uint32_t randomState = 1;
+
+void seedRandom(uint32_t seed) { randomState = seed != 0 ? seed : 1; }
+
+double random() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState / 4294967296.0;
+}
+
+double noise(double sigma) {
+  if (sigma == 0)
+    return 0;
+  // Box-Muller, with 1 - random() never 0
+  double u = 1 - random(), v = random();
+  return sigma * sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                             Screens and SD card                           */
+/*---------------------------------------------------------------------------*/
+
+void screenText(const char *where, const char *text) {
+  if (options.echoScreen)
+    fprintf(stderr, "%9.1f %-10s %s\n", now(), where, text);
+}
+
+static void sdPath(char *path, int size, const char *name) {
+  snprintf(path, size, "%s/%s", options.sdDirectory, name);
+}
+
+bool sdInserted() {
+  struct stat info;
+  return options.sdDirectory != NULL &&
+         stat(options.sdDirectory, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+int32_t sdLoad(const char *name, uint8_t *buffer, int32_t length) {
+  char path[512];
+  sdPath(path, sizeof(path), name);
+  FILE *file = sdInserted() ? fopen(path, "rb") : NULL;
+  if (file == NULL)
+    return 0;
+  int32_t read = (int32_t)fread(buffer, 1, length, file);
+  fclose(file);
+  return read;
+}
+
+int32_t sdSave(const char *name, const uint8_t *buffer, int32_t length,
+               bool append) {
+  char path[512];
+  sdPath(path, sizeof(path), name);
+  FILE *file = sdInserted() ? fopen(path, append ? "ab" : "wb") : NULL;
+  if (file == NULL)
+    return 0;
+  int32_t written = (int32_t)fwrite(buffer, 1, length, file);
+  fclose(file);
+  return written;
+}
+
+int32_t sdSize(const char *name) {
+  char path[512];
+  sdPath(path, sizeof(path), name);
+  struct stat info;
+  if (!sdInserted() || stat(path, &info) != 0)
+    return -1;
+  return (int32_t)info.st_size;
+}
+
+} // namespace sim
@@ -0,0 +1,142 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "steps.h"
+
+namespace sim {
+
+const Step stepTolerance = {100, {1, 1, 2}, 30, {30, 30}, 30, 0.02};
+
+// The drive is at rest below stillRpm, and a step has ended once it has
+// been at rest for stillMs
+static const double stillRpm = 5;
+static const double stillMs = 100;
+
+static Step steps[maxSteps];
+static int count;
+static bool driving;
+static Step stopped; // where the drive last came to rest
+static bool resting;
+
+Step snapshot(double time) {
+  const Robot &r = robot;
+  Step step;
+  step.time = time;
+  step.at = pose();
+  // both motors turn the one shaft, but either may be left coasting
+  step.flywheelRpm = motors[r.flywheel[0]].rpm;
+  for (int i = 0; i < 2; i++) {
+    const Motor &m = motors[r.flywheel[i]];
+    step.flywheelTargetRpm[i] = m.mode == motorVelocity ? m.targetRpm : 0;
+  }
+  step.intakeRpm = motors[r.intake].rpm;
+  step.armRevs = motors[r.arm].revs;
+  return step;
+}
+
+void watchSteps(double time) {
+  const Robot &r = robot;
+  int drive[] = {r.leftDrive[0], r.leftDrive[1], r.rightDrive[0],
+                 r.rightDrive[1]};
+  bool moving = false;
+  for (int i = 0; i < 4; i++)
+    moving = moving || fabs(motors[drive[i]].rpm) > stillRpm;
+
+  if (moving) {
+    driving = true;
+    resting = false;
+  } else if (driving && !resting) {
+    stopped = snapshot(time);
+    resting = true;
+  } else if (resting && time - stopped.time >= stillMs) {
+    if (count < maxSteps)
+      steps[count++] = stopped;
+    driving = resting = false;
+  }
+}
+
+static void writeStep(FILE *file, const char *name, const Step &step) {
+  fprintf(file, "%s,%.0f,%.2f,%.2f,%.2f,%.1f,%.0f,%.0f,%.1f,%.4f\n", name,
+          step.time, step.at.x, step.at.y, step.at.heading, step.flywheelRpm,
+          step.flywheelTargetRpm[0], step.flywheelTargetRpm[1],
+          step.intakeRpm, step.armRevs);
+}
+
+int stepCount() { return count; }
+const Step &step(int index) { return steps[index]; }
+
+bool writeSteps(const char *path, const Step &end) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(file, "step,time_ms,x_in,y_in,heading_deg,flywheel_rpm,"
+                "flywheel1_target_rpm,flywheel2_target_rpm,intake_rpm,"
+                "arm_revs\n");
+  for (int i = 0; i < count; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "%d", i + 1);
+    writeStep(file, name, steps[i]);
+  }
+  writeStep(file, "end", end);
+  fclose(file);
+  return true;
+}
+
+int readSteps(const char *path, Step *read, int most) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    perror(path);
+    return -1;
+  }
+  char line[256];
+  int found = 0;
+  while (found < most && fgets(line, sizeof(line), file) != NULL) {
+    Step &s = read[found];
+    char name[16];
+    if (sscanf(line, "%15[^,],%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", name,
+               &s.time, &s.at.x, &s.at.y, &s.at.heading, &s.flywheelRpm,
+               &s.flywheelTargetRpm[0], &s.flywheelTargetRpm[1],
+               &s.intakeRpm, &s.armRevs) == 10)
+      found++;
+  }
+  fclose(file);
+  return found;
+}
+
+static bool near(const char *step, const char *what, double got,
+                 double expected, double within, bool say) {
+  if (fabs(got - expected) <= within)
+    return true;
+  if (say)
+    printf("step %s: %s is %g, expected %g within %g\n", step, what, got,
+           expected, within);
+  return false;
+}
+
+bool sameStep(const char *name, const Step &got, const Step &expected,
+              double slack, bool say) {
+  const Step &t = stepTolerance;
+  bool same = near(name, "time_ms", got.time, expected.time, slack * t.time,
+                   say);
+  same &= near(name, "x_in", got.at.x, expected.at.x, slack * t.at.x, say);
+  same &= near(name, "y_in", got.at.y, expected.at.y, slack * t.at.y, say);
+  same &= near(name, "heading_deg", got.at.heading, expected.at.heading,
+               slack * t.at.heading, say);
+  same &= near(name, "flywheel_rpm", got.flywheelRpm, expected.flywheelRpm,
+               slack * t.flywheelRpm, say);
+  same &= near(name, "flywheel1_target_rpm", got.flywheelTargetRpm[0],
+               expected.flywheelTargetRpm[0], slack * t.flywheelTargetRpm[0],
+               say);
+  same &= near(name, "flywheel2_target_rpm", got.flywheelTargetRpm[1],
+               expected.flywheelTargetRpm[1], slack * t.flywheelTargetRpm[1],
+               say);
+  same &= near(name, "intake_rpm", got.intakeRpm, expected.intakeRpm,
+               slack * t.intakeRpm, say);
+  same &= near(name, "arm_revs", got.armRevs, expected.armRevs,
+               slack * t.armRevs, say);
+  return same;
+}
+
+} // namespace sim
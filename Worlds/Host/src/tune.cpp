@@ -0,0 +1,561 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "steps.h"
+
+/*---------------------------------------------------------------------------*/
+/*                                Gain Tuner                                 */
+/*                                                                           */
+/*  Searches a program's motion gains for the fastest set that still ends    */
+/*  every move its routines make on that move's goal, and prints it ready to */
+/*  use. Only a program that keeps its gains where they can be changed at    */
+/*  run time can be tuned, which is AutonSelector: a MotionGains struct      */
+/*  called gains, forward() with the minimum speed as an argument and        */
+/*  stopH() to follow it, as its steps run them, and turn(). They are linked */
+/*  as weak symbols, like the benchmark's.                                   */
+/*                                                                           */
+/*  The program has one set of gains for all its drives and one for all its  */
+/*  turns, so each set is tuned against every move of its kind the routines  */
+/*  make, each drive starting from the minimum speed its step gives. A move  */
+/*  is timed from the call until the drive has come to rest, and is accurate */
+/*  when it comes to rest within the step tolerances in steps.h of its goal: */
+/*  the inches asked for along the starting heading, or the wheel degrees    */
+/*  asked for. A set's cost is the time its moves take, and a set with a     */
+/*  move that is not accurate or does not finish is out.                     */
+/*                                                                           */
+/*  The search is a compass search: each round tries every gain a step up    */
+/*  and down, keeps the fastest set that is better, and halves the steps     */
+/*  when none is. Every move of every set tried in a round is its own run,   */
+/*  forked across the cores, on the nominal plant unless --set changes it.   */
+/*                                                                           */
+/*    build/tune-AutonSelector [--jobs n] [--rounds n] [--only class]        */
+/*                             [--set parameter=value ...]                   */
+/*---------------------------------------------------------------------------*/
+
+// The program's gains and moves, field for field and argument for argument.
+// The moves return the program's StepOutcome, which is an int.
+struct MotionGains {
+  double acceleration;
+  double deceleration;
+  double turnMinimum;
+  double turnAcceleration;
+  double turnDeceleration;
+};
+
+extern MotionGains gains __attribute__((weak));
+int forward(double distanceIn, double maxVelocity, double minimum,
+            uint32_t deadlineMs) __attribute__((weak));
+int turn(double degrees, double maxVelocity, uint32_t deadlineMs)
+    __attribute__((weak));
+void stopH() __attribute__((weak));
+
+static const int stepDone = 1;
+
+// A gain the search steps, and the range it keeps it in
+struct Gain {
+  const char *name;
+  double MotionGains::*field;
+  double low, high;
+  double step; // the first one
+};
+
+struct Move {
+  double value;   // in, or wheel degrees for a turn
+  double speed;   // pct
+  double minimum; // pct a drive starts from, as its step has it
+};
+
+static const int maxGains = 3;
+static const int maxMoves = 32;
+
+struct MoveClass {
+  const char *name;
+  bool turning;
+  Gain gains[maxGains]; // ends at a NULL name
+  Move moves[maxMoves]; // ends at speed 0
+};
+
+// Every drive and turn in routines.h, each once. A turn takes turnMinimum
+// from the gains, so only turns tune a minimum.
+static const MoveClass classes[] = {
+    {"forward",
+     false,
+     {{"acceleration", &MotionGains::acceleration, 5, 300, 20},
+      {"deceleration", &MotionGains::deceleration, 5, 300, 20}},
+     {{-0.5, 100, 50}, {-1.5, 80, 50}, {-3, 50, 50}, {-3, 70, 50},
+      {4, 55, 40}, {4, 80, 50}, {4.1, 50, 40}, {-4.5, 50, 40},
+      {4.5, 50, 40}, {4.65, 50, 50}, {-6, 70, 50}, {8.8, 70, 50},
+      {-17.5, 70, 50}, {19, 70, 50}, {23, 95, 50}, {24.5, 80, 40},
+      {25, 60, 40}, {27.3, 100, 60}, {27.5, 100, 60}, {-34, 85, 30},
+      {-34.5, 97, 50}, {-37, 85, 30}, {37.5, 100, 50}, {37.5, 100, 60},
+      {40, 100, 50}, {40.2, 80, 50}, {41, 100, 50}, {42, 100, 60},
+      {42.3, 100, 60}, {43.3, 100, 60}, {45.8, 100, 50}, {46, 100, 50}}},
+    {"turn",
+     true,
+     {{"turnMinimum", &MotionGains::turnMinimum, 5, 100, 10},
+      {"turnAcceleration", &MotionGains::turnAcceleration, 5, 300, 20},
+      {"turnDeceleration", &MotionGains::turnDeceleration, 5, 300, 20}},
+     {{-9, 70}, {-33, 70}, {-63, 70}, {-173, 70}, {177, 70}, {228, 70},
+      {270, 70}, {-275, 70}, {-275, 80}, {275, 70}, {275, 80}, {282, 70},
+      {340, 70}, {-372, 70}, {378, 70}}},
+};
+
+static const int classCount = sizeof(classes) / sizeof(MoveClass);
+
+static int gainCount(const MoveClass &c) {
+  int count = 0;
+  while (count < maxGains && c.gains[count].name != NULL)
+    count++;
+  return count;
+}
+
+static int moveCount(const MoveClass &c) {
+  int count = 0;
+  while (count < maxMoves && c.moves[count].speed != 0)
+    count++;
+  return count;
+}
+
+// How far from its goal a move may come to rest: the step tolerance, as
+// wheel degrees for a turn
+static double tolerance(const MoveClass &c) {
+  const sim::Pose &at = sim::stepTolerance.at;
+  return c.turning
+             ? at.heading * sim::robot.trackWidth / sim::robot.wheelDiameter
+             : at.x;
+}
+
+static const double smallestStep = 1;
+
+static const uint32_t restMs = 50;       // before the move
+static const uint32_t timeoutMs = 8000;  // to come to rest
+static const double stillRpm = 5;        // the drive is at rest below this
+static const uint32_t stillMs = 50;      // for this long
+
+/*---------------------------------------------------------------------------*/
+/*                                One move                                   */
+/*---------------------------------------------------------------------------*/
+
+// One move with one set of gains
+struct Trial {
+  int moveClass;
+  int move;
+  double gains[maxGains];
+};
+
+// What a run sends back to the tuner
+struct Result {
+  bool finished; // the move returned done and the drive came to rest
+  double timeMs; // from the call to rest
+  double error;  // past the goal where it came to rest, in the goal's units
+};
+
+enum Stage { resting, moving, watching };
+
+static const Trial *trial;
+static Stage stage;
+static double startedAt, stillSince;
+static sim::Pose startPose;
+static double startRevs[4]; // of the drive motors, left then right
+static int outcome;
+static Result result;
+
+// Lock held. The drive motors, left front and back then right
+static void driveRevs(double *revs) {
+  const sim::Robot &r = sim::robot;
+  int drive[] = {r.leftDrive[0], r.leftDrive[1], r.rightDrive[0],
+                 r.rightDrive[1]};
+  for (int i = 0; i < 4; i++)
+    revs[i] = sim::motors[drive[i]].revs;
+}
+
+// Lock held. How far the move has gone, in its goal's units: inches along
+// the starting heading, or the wheel degrees each side turned for a turn
+static double travelled() {
+  if (classes[trial->moveClass].turning) {
+    double revs[4];
+    driveRevs(revs);
+    double left = revs[0] + revs[1] - startRevs[0] - startRevs[1];
+    double right = revs[2] + revs[3] - startRevs[2] - startRevs[3];
+    return (left - right) / 4 * 360;
+  }
+  sim::Pose at = sim::pose();
+  double h = startPose.heading * M_PI / 180;
+  return (at.x - startPose.x) * sin(h) + (at.y - startPose.y) * cos(h);
+}
+
+static int runMove() {
+  sim::sleepMs(restMs);
+  const MoveClass &c = classes[trial->moveClass];
+  const Move &m = c.moves[trial->move];
+  uint32_t deadline;
+  {
+    sim::Guard guard;
+    startedAt = sim::now();
+    startPose = sim::pose();
+    driveRevs(startRevs);
+    deadline = (uint32_t)startedAt + timeoutMs;
+    stage = moving;
+  }
+
+  if (c.turning) {
+    outcome = turn(m.value, m.speed, deadline);
+  } else {
+    outcome = forward(m.value, m.speed, m.minimum, deadline);
+    stopH();
+  }
+
+  {
+    sim::Guard guard;
+    stage = watching;
+  }
+  sim::sleepMs(timeoutMs);
+  return 0;
+}
+
+// Lock held
+static double driveRpm() {
+  const sim::Robot &r = sim::robot;
+  int drive[] = {r.leftDrive[0], r.leftDrive[1], r.rightDrive[0],
+                 r.rightDrive[1]};
+  double rpm = 0;
+  for (int i = 0; i < 4; i++)
+    rpm = fmax(rpm, fabs(sim::motors[drive[i]].rpm));
+  return rpm;
+}
+
+static bool watch(double time) {
+  if (stage == resting)
+    return true;
+  if (time - startedAt >= timeoutMs)
+    return false;
+  if (stage == moving || driveRpm() >= stillRpm) {
+    stillSince = time;
+    return true;
+  }
+  if (time - stillSince < stillMs)
+    return true;
+
+  const Move &m = classes[trial->moveClass].moves[trial->move];
+  result.finished = outcome == stepDone;
+  result.timeMs = stillSince - startedAt;
+  result.error = (travelled() - m.value) * (m.value >= 0 ? 1 : -1);
+  return false;
+}
+
+// In the child: one fresh run of the move, written to out
+static void runTrial(const sim::Options &options, int out) {
+  sim::start(options);
+  const MoveClass &c = classes[trial->moveClass];
+  for (int k = 0; k < gainCount(c); k++)
+    gains.*c.gains[k].field = trial->gains[k];
+  sim::startTask(runMove, 7);
+  sim::run(watch);
+
+  ssize_t written = write(out, &result, sizeof(result));
+  _exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+}
+
+// Runs every trial, jobs at a time, a failed run counting as not finished
+static void runTrials(const sim::Options &options, const Trial *trials,
+                      Result *results, int count, int jobs) {
+  pid_t *children = (pid_t *)calloc(count, sizeof(pid_t));
+  int *pipes = (int *)calloc(count, sizeof(int));
+  int started = 0, finished = 0;
+  fflush(stdout);
+
+  while (finished < count) {
+    if (started < count && started - finished < jobs) {
+      int ends[2];
+      if (pipe(ends) != 0) {
+        perror("pipe");
+        exit(1);
+      }
+      trial = &trials[started];
+      pid_t child = fork();
+      if (child < 0) {
+        perror("fork");
+        exit(1);
+      }
+      if (child == 0) {
+        close(ends[0]);
+        runTrial(options, ends[1]);
+      }
+      close(ends[1]);
+      children[started] = child;
+      pipes[started] = ends[0];
+      started++;
+      continue;
+    }
+
+    int status = 0;
+    pid_t child = wait(&status);
+    int run = 0;
+    while (run < started && children[run] != child)
+      run++;
+    if (run == started)
+      continue;
+    ssize_t got = read(pipes[run], &results[run], sizeof(Result));
+    close(pipes[run]);
+    if (got != (ssize_t)sizeof(Result) || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0)
+      memset(&results[run], 0, sizeof(Result));
+    finished++;
+  }
+  free(children);
+  free(pipes);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                  Search                                   */
+/*---------------------------------------------------------------------------*/
+
+// A set of gains for one class and how it did
+struct Candidate {
+  double gains[maxGains];
+  bool accurate;     // every move finished within tolerance of its goal
+  double timeMs;     // of all the class's moves
+  double worstError; // furthest any move came to rest from its goal
+};
+
+struct Tuning {
+  const MoveClass *moveClass;
+  int gains, moves;
+  bool tuning;
+  double steps[maxGains];
+  Candidate start, best;
+};
+
+// Scores a candidate from its moves' results
+static void score(Candidate &candidate, const Tuning &tuning,
+                  const Result *results) {
+  double allowed = tolerance(*tuning.moveClass);
+  candidate.accurate = true;
+  candidate.timeMs = candidate.worstError = 0;
+  for (int m = 0; m < tuning.moves; m++) {
+    const Result &r = results[m];
+    candidate.timeMs += r.timeMs;
+    candidate.worstError = fmax(candidate.worstError, fabs(r.error));
+    candidate.accurate &= r.finished && fabs(r.error) <= allowed;
+  }
+}
+
+// An accurate set beats one that is not, and then the faster one wins
+static bool beats(const Candidate &c, const Candidate &best) {
+  return c.accurate && (!best.accurate || c.timeMs < best.timeMs);
+}
+
+static void addTrials(Trial *trials, int &count, int moveClass, int moves,
+                      const double *gains) {
+  for (int m = 0; m < moves; m++) {
+    Trial &t = trials[count++];
+    t.moveClass = moveClass;
+    t.move = m;
+    memcpy(t.gains, gains, sizeof(t.gains));
+  }
+}
+
+static void printRows(const Tuning &tuning) {
+  const MoveClass &c = *tuning.moveClass;
+  const Candidate &s = tuning.start, &b = tuning.best;
+  for (int k = 0; k < tuning.gains; k++)
+    printf("%s,%s,%d,%.0f,%.0f,%.0f,%.0f,%.2f,%s,%s\n", c.name,
+           c.gains[k].name, tuning.moves, b.gains[k], s.gains[k], b.timeMs,
+           s.timeMs, b.worstError, c.turning ? "deg" : "in",
+           b.accurate ? "yes" : "no");
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                  Runner                                   */
+/*---------------------------------------------------------------------------*/
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--jobs n] [--rounds n] [--only class]\n"
+          "          [--set parameter=value ...]\n"
+          "classes:",
+          name);
+  for (int i = 0; i < classCount; i++)
+    fprintf(stderr, " %s", classes[i].name);
+  fprintf(stderr, "\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  if (&gains == NULL || forward == NULL || stopH == NULL || turn == NULL) {
+    fprintf(stderr, "%s: the program has no MotionGains gains, forward(), "
+                    "stopH() and turn() to tune\n",
+            argv[0]);
+    return 1;
+  }
+
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start.x = 72;
+  options.start.y = 72;
+  options.start.heading = 0;
+  options.sdDirectory = NULL;
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int rounds = 40;
+  const char *only = NULL;
+
+  for (int i = 1; i < argc; i += 2) {
+    const char *option = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (value == NULL)
+      usage(argv[0]);
+    if (strcmp(option, "--jobs") == 0) {
+      jobs = atoi(value);
+    } else if (strcmp(option, "--rounds") == 0) {
+      rounds = atoi(value);
+    } else if (strcmp(option, "--only") == 0) {
+      only = value;
+    } else if (strcmp(option, "--set") == 0) {
+      char name[64];
+      double number;
+      if (sscanf(value, "%63[^=]=%lf", name, &number) != 2 ||
+          !sim::setParameter(name, number))
+        usage(argv[0]);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (jobs < 1 || rounds < 0)
+    usage(argv[0]);
+
+  static Tuning tunings[classCount];
+  int tuned = 0;
+  for (int i = 0; i < classCount; i++) {
+    Tuning &t = tunings[i];
+    const MoveClass &c = classes[i];
+    t.moveClass = &c;
+    t.gains = gainCount(c);
+    t.moves = moveCount(c);
+    t.tuning = only == NULL || strcmp(only, c.name) == 0;
+    tuned += t.tuning;
+    for (int k = 0; k < t.gains; k++) {
+      t.start.gains[k] = gains.*c.gains[k].field;
+      t.steps[k] = c.gains[k].step;
+    }
+  }
+  if (tuned == 0)
+    usage(argv[0]);
+
+  // at most every neighbour of every class's set, each move of it
+  int most = classCount * 2 * maxGains * maxMoves;
+  Trial *trials = (Trial *)calloc(most, sizeof(Trial));
+  Result *results = (Result *)calloc(most, sizeof(Result));
+
+  // the gains the program has now, for what the search has to beat
+  int count = 0;
+  for (int i = 0; i < classCount; i++) {
+    if (tunings[i].tuning)
+      addTrials(trials, count, i, tunings[i].moves, tunings[i].start.gains);
+  }
+  runTrials(options, trials, results, count, jobs);
+  count = 0;
+  for (int i = 0; i < classCount; i++) {
+    Tuning &t = tunings[i];
+    if (!t.tuning)
+      continue;
+    score(t.start, t, &results[count]);
+    count += t.moves;
+    t.best = t.start;
+    if (!t.start.accurate)
+      fprintf(stderr, "%s: a move ends %.2f %s from its goal with the "
+                      "starting gains\n",
+              t.moveClass->name, t.start.worstError,
+              t.moveClass->turning ? "deg" : "in");
+  }
+
+  static Candidate neighbours[classCount][2 * maxGains];
+  for (int round = 0; round < rounds; round++) {
+    // every gain a step either way, where that is still within its limits
+    int tried[classCount];
+    count = 0;
+    for (int i = 0; i < classCount; i++) {
+      Tuning &t = tunings[i];
+      tried[i] = 0;
+      if (!t.tuning)
+        continue;
+      for (int k = 0; k < t.gains; k++) {
+        const Gain &gain = t.moveClass->gains[k];
+        for (int sign = -1; sign <= 1; sign += 2) {
+          double value = t.best.gains[k] + sign * t.steps[k];
+          if (value < gain.low || value > gain.high)
+            continue;
+          Candidate &n = neighbours[i][tried[i]++];
+          n = t.best;
+          n.gains[k] = value;
+          addTrials(trials, count, i, t.moves, n.gains);
+        }
+      }
+    }
+    if (count == 0)
+      break;
+    runTrials(options, trials, results, count, jobs);
+
+    count = 0;
+    int searching = 0;
+    for (int i = 0; i < classCount; i++) {
+      Tuning &t = tunings[i];
+      if (!t.tuning)
+        continue;
+      Candidate *better = NULL;
+      for (int n = 0; n < tried[i]; n++) {
+        Candidate &c = neighbours[i][n];
+        score(c, t, &results[count]);
+        count += t.moves;
+        if (beats(c, better != NULL ? *better : t.best))
+          better = &c;
+      }
+      if (better != NULL) {
+        t.best = *better;
+      } else {
+        bool small = true;
+        for (int k = 0; k < t.gains; k++) {
+          t.steps[k] /= 2;
+          small &= t.steps[k] < smallestStep;
+        }
+        t.tuning = !small;
+      }
+      searching += t.tuning;
+      fprintf(stderr, "round %d %s %.0f ms\n", round + 1, t.moveClass->name,
+              t.best.timeMs);
+    }
+    if (searching == 0)
+      break;
+  }
+
+  printf("class,gain,moves,value,start_value,time_ms,start_time_ms,"
+         "worst_error,units,accurate\n");
+  MotionGains set = gains;
+  for (int i = 0; i < classCount; i++) {
+    const Tuning &t = tunings[i];
+    if (only != NULL && strcmp(only, classes[i].name) != 0)
+      continue;
+    printRows(t);
+    for (int k = 0; k < t.gains; k++)
+      set.*classes[i].gains[k].field = t.best.gains[k];
+  }
+  // the one set the program keeps, ready to paste over its own
+  fprintf(stderr, "MotionGains gains = {%.1f, %.1f, %.1f, %.1f, %.1f};\n",
+          set.acceleration, set.deceleration, set.turnMinimum,
+          set.turnAcceleration, set.turnDeceleration);
+  free(trials);
+  free(results);
+  return 0;
+}
@@ -0,0 +1,505 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "sim.h"
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                              Host vex API                                 */
+/*                                                                           */
+/*  Each call takes the simulator lock, which also brings the plant up to    */
+/*  now, and works on the device behind the port. Units are converted here   */
+/*  so the simulator only ever sees output shaft revs and rpm. Reading the   */
+/*  clock is a call too, so a loop that only watches the time still lets     */
+/*  the other tasks run.                                                     */
+/*---------------------------------------------------------------------------*/
+
+using namespace vex;
+
+static color clearColor() {
+  color c;
+  c.clear = true;
+  return c;
+}
+
+const color color::transparent = clearColor();
+const color color::black(0x000000);
+const color color::white(0xffffff);
+const color color::red(0xff0000);
+const color color::green(0x00ff00);
+const color color::blue(0x0000ff);
+const color color::yellow(0xffff00);
+
+static double clockMs() {
+  sim::Guard guard;
+  return sim::now();
+}
+
+static uint64_t clockMicros() {
+  sim::Guard guard;
+  return sim::nowMicros();
+}
+
+uint32_t vexSystemTimeGet(void) { return (uint32_t)clockMs(); }
+uint64_t vexSystemHighResolutionTimeGet(void) { return clockMicros(); }
+
+/*---------------------------------------------------------------------------*/
+/*                                 Motors                                    */
+/*---------------------------------------------------------------------------*/
+
+static double cartridgeRpm(gearSetting gears) {
+  return gears == gearSetting::ratio36_1   ? 100
+         : gears == gearSetting::ratio6_1 ? 600
+                                          : 200;
+}
+
+static double toRpm(const sim::Motor &m, double value, velocityUnits units) {
+  return units == velocityUnits::pct   ? value / 100 * m.maxRpm
+         : units == velocityUnits::dps ? value / 6
+                                       : value;
+}
+
+static double toRevs(const sim::Motor &m, double value, rotationUnits units) {
+  return units == rotationUnits::deg   ? value / 360
+         : units == rotationUnits::raw ? value / m.ticksPerRev
+                                       : value;
+}
+
+static sim::MotorMode stopMode(brakeType mode) {
+  return mode == brakeType::hold    ? sim::motorHolding
+         : mode == brakeType::brake ? sim::motorBraking
+                                    : sim::motorCoasting;
+}
+
+static void openMotor(int32_t port, gearSetting gears) {
+  sim::Motor &m = sim::motor(port);
+  if (m.used)
+    return;
+  m.used = true;
+  m.maxRpm = cartridgeRpm(gears);
+  m.ticksPerRev = 180000 / m.maxRpm; // 1800 on 36:1 down to 300 on 6:1
+  m.velocity = m.maxRpm / 2;
+  m.direction = 1;
+  m.stopping = sim::motorCoasting;
+  m.mode = sim::motorCoasting;
+}
+
+motor::motor(int32_t index, bool reverse) : port(index) {
+  openMotor(index, gearSetting::ratio18_1);
+}
+
+motor::motor(int32_t index, gearSetting gears, bool reverse) : port(index) {
+  openMotor(index, gears);
+}
+
+void motor::spin(directionType dir) {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  m.mode = sim::motorVelocity;
+  m.direction = dir == directionType::rev ? -1 : 1;
+  m.targetRpm = m.direction * m.velocity;
+}
+
+void motor::spin(directionType dir, double velocity, velocityUnits units) {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  m.velocity = toRpm(m, velocity, units);
+  m.mode = sim::motorVelocity;
+  m.direction = dir == directionType::rev ? -1 : 1;
+  m.targetRpm = m.direction * m.velocity;
+}
+
+// Changes the speed of a spinning motor without starting a stopped one
+void motor::setVelocity(double velocity, velocityUnits units) {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  m.velocity = toRpm(m, velocity, units);
+  if (m.mode == sim::motorVelocity)
+    m.targetRpm = m.direction * m.velocity;
+}
+
+void motor::stop() {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  m.mode = m.stopping;
+  m.targetRevs = m.revs;
+}
+
+void motor::stop(brakeType mode) {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  m.mode = stopMode(mode);
+  m.targetRevs = m.revs;
+}
+
+void motor::setStopping(brakeType mode) {
+  sim::Guard guard;
+  sim::motor(port).stopping = stopMode(mode);
+}
+
+void motor::setTimeout(int32_t time, timeUnits units) {
+  sim::Guard guard;
+  sim::motor(port).timeoutMs = units == timeUnits::sec ? time * 1000 : time;
+}
+
+bool motor::moveTo(double revs, double rpm, bool waitForCompletion) {
+  double timeoutMs;
+  {
+    sim::Guard guard;
+    sim::Motor &m = sim::motor(port);
+    m.mode = sim::motorPosition;
+    m.targetRevs = revs;
+    m.targetRpm = fabs(rpm);
+    m.moveStarted = sim::now();
+    m.moveDone = false;
+    timeoutMs = m.timeoutMs;
+  }
+  if (!waitForCompletion)
+    return true;
+
+  for (;;) {
+    {
+      sim::Guard guard;
+      sim::Motor &m = sim::motor(port);
+      if (m.mode != sim::motorPosition || m.moveDone)
+        return m.moveDone;
+      if (timeoutMs > 0 && sim::now() - m.moveStarted >= timeoutMs) {
+        m.mode = m.stopping;
+        m.targetRevs = m.revs;
+        return false;
+      }
+    }
+    sim::sleepMs(1);
+  }
+}
+
+bool motor::rotateTo(double rotation, rotationUnits units, double velocity,
+                     velocityUnits units_v, bool waitForCompletion) {
+  double revs, rpm;
+  {
+    sim::Guard guard;
+    sim::Motor &m = sim::motor(port);
+    revs = toRevs(m, rotation, units);
+    rpm = toRpm(m, velocity, units_v);
+  }
+  return moveTo(revs, rpm, waitForCompletion);
+}
+
+bool motor::rotateFor(double rotation, rotationUnits units, double velocity,
+                      velocityUnits units_v, bool waitForCompletion) {
+  double revs, rpm;
+  {
+    sim::Guard guard;
+    sim::Motor &m = sim::motor(port);
+    revs = m.revs + toRevs(m, rotation, units);
+    rpm = toRpm(m, velocity, units_v);
+  }
+  return moveTo(revs, rpm, waitForCompletion);
+}
+
+bool motor::rotateFor(directionType dir, double rotation, rotationUnits units,
+                      bool waitForCompletion) {
+  return rotateFor(dir == directionType::rev ? -rotation : rotation, units,
+                   waitForCompletion);
+}
+
+bool motor::rotateFor(double rotation, rotationUnits units,
+                      bool waitForCompletion) {
+  double revs, rpm;
+  {
+    sim::Guard guard;
+    sim::Motor &m = sim::motor(port);
+    revs = m.revs + toRevs(m, rotation, units);
+    rpm = m.velocity;
+  }
+  return moveTo(revs, rpm, waitForCompletion);
+}
+
+double motor::rotation(rotationUnits units) {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  return units == rotationUnits::deg   ? m.revs * 360
+         : units == rotationUnits::raw ? m.revs * m.ticksPerRev
+                                       : m.revs;
+}
+
+void motor::resetRotation() { setRotation(0, rotationUnits::rev); }
+
+// Moves the zero, so a move or hold under way keeps its place on the shaft
+void motor::setRotation(double value, rotationUnits units) {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  double shift = toRevs(m, value, units) - m.revs;
+  m.revs += shift;
+  m.targetRevs += shift;
+}
+
+double motor::velocity(velocityUnits units) {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  return units == velocityUnits::pct   ? m.rpm / m.maxRpm * 100
+         : units == velocityUnits::dps ? m.rpm * 6
+                                       : m.rpm;
+}
+
+double motor::current(currentUnits units) {
+  sim::Guard guard;
+  return sim::motor(port).amps;
+}
+
+double motor::temperature(temperatureUnits units) {
+  return units == temperatureUnits::fahrenheit ? 77 : 25;
+}
+
+bool motor::installed() {
+  sim::Guard guard;
+  return sim::motor(port).used;
+}
+
+bool motor::isSpinning() {
+  sim::Guard guard;
+  sim::Motor &m = sim::motor(port);
+  return (m.mode == sim::motorVelocity && m.targetRpm != 0) ||
+         (m.mode == sim::motorPosition && !m.moveDone);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                  Brain                                    */
+/*---------------------------------------------------------------------------*/
+
+timer::timer() : startedAt(clockMs()) {}
+
+double timer::time(timeUnits units) {
+  double ms = clockMs() - startedAt;
+  return units == timeUnits::sec ? ms / 1000 : ms;
+}
+
+double timer::time() { return time(timeUnits::msec); }
+void timer::clear() { startedAt = clockMs(); }
+uint32_t timer::value() { return (uint32_t)time(timeUnits::sec); }
+uint32_t timer::system() { return (uint32_t)clockMs(); }
+uint64_t timer::systemHighResolution() { return clockMicros(); }
+
+static void echo(const char *where, const char *format, va_list args) {
+  char text[256];
+  vsnprintf(text, sizeof(text), format, args);
+  sim::screenText(where, text);
+}
+
+void brain::lcd::print(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  echo("brain", format, args);
+  va_end(args);
+}
+
+void brain::lcd::printAt(int32_t x, int32_t y, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  echo("brain", format, args);
+  va_end(args);
+}
+
+void brain::lcd::printAt(int32_t x, int32_t y, bool opaque,
+                         const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  echo("brain", format, args);
+  va_end(args);
+}
+
+void brain::lcd::setCursor(int32_t row, int32_t col) {}
+void brain::lcd::newLine() {}
+void brain::lcd::clearScreen() {}
+void brain::lcd::clearScreen(const color &c) {}
+void brain::lcd::clearLine() {}
+void brain::lcd::clearLine(int32_t number) {}
+void brain::lcd::setFont(fontType font) {}
+void brain::lcd::setPenColor(const color &c) {}
+void brain::lcd::setFillColor(const color &c) {}
+void brain::lcd::setPenWidth(uint32_t width) {}
+void brain::lcd::drawLine(int x1, int y1, int x2, int y2) {}
+void brain::lcd::drawRectangle(int x, int y, int width, int height) {}
+void brain::lcd::drawRectangle(int x, int y, int width, int height,
+                               const color &c) {}
+
+// Nobody touches the screen on the host
+int32_t brain::lcd::xPosition() { return x; }
+int32_t brain::lcd::yPosition() { return y; }
+void brain::lcd::pressed(void (*callback)(void)) {}
+void brain::lcd::released(void (*callback)(void)) {}
+
+bool brain::lcd::render() { return true; }
+bool brain::lcd::render(bool vsyncWait, bool runScheduler) { return true; }
+
+uint32_t brain::battery::capacity(percentUnits units) {
+  sim::Guard guard;
+  return (uint32_t)(sim::batteryPercent() + 0.5);
+}
+
+double brain::battery::temperature(percentUnits units) { return 0; }
+
+bool brain::sdcard::isInserted() { return sim::sdInserted(); }
+
+// AutonSelector's selector buttons, field for field, linked weak so only a
+// program that has them gets them pressed
+struct SelectorButton {
+  int xpos, ypos, width, height;
+  bool state;
+  color offColor, onColor;
+  const char *label;
+};
+
+extern SelectorButton buttons[] __attribute__((weak));
+
+static const int selectorButtons = 6;
+
+bool sim::pressSelector(int mask) {
+  if (buttons == NULL)
+    return false;
+  for (int i = 0; i < selectorButtons; i++)
+    buttons[i].state = (mask >> i) & 1;
+  return true;
+}
+
+int32_t brain::sdcard::loadfile(const char *name, uint8_t *buffer,
+                                int32_t len) {
+  return sim::sdLoad(name, buffer, len);
+}
+
+int32_t brain::sdcard::savefile(const char *name, uint8_t *buffer,
+                                int32_t len) {
+  return sim::sdSave(name, buffer, len, false);
+}
+
+int32_t brain::sdcard::appendfile(const char *name, uint8_t *buffer,
+                                  int32_t len) {
+  return sim::sdSave(name, buffer, len, true);
+}
+
+int32_t brain::sdcard::size(const char *name) { return sim::sdSize(name); }
+bool brain::sdcard::exists(const char *name) { return sim::sdSize(name) >= 0; }
+
+void controller::lcd::print(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  echo("controller", format, args);
+  va_end(args);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                             Three-wire sensors                            */
+/*---------------------------------------------------------------------------*/
+
+// The gyro reads zero while it calibrates and from where it was left after
+const double gyroCalibrationMs = 1000;
+static double gyroZero[sim::triportCount];
+static double gyroCalibratedAt[sim::triportCount];
+
+gyro::gyro(triport::port &port) : index(port.index) {}
+
+double gyro::value(rotationUnits units) {
+  sim::Guard guard;
+  if (sim::now() < gyroCalibratedAt[index])
+    return 0;
+  double degrees = sim::gyroHeading() - gyroZero[index];
+  return units == rotationUnits::rev   ? degrees / 360
+         : units == rotationUnits::raw ? degrees * 10
+                                       : degrees;
+}
+
+void gyro::startCalibration(int32_t value) {
+  sim::Guard guard;
+  gyroCalibratedAt[index] = sim::now() + gyroCalibrationMs;
+  gyroZero[index] = sim::gyroHeading();
+}
+
+bool gyro::isCalibrating() {
+  sim::Guard guard;
+  if (sim::now() < gyroCalibratedAt[index]) {
+    gyroZero[index] = sim::gyroHeading();
+    return true;
+  }
+  return false;
+}
+
+sonar::sonar(triport::port &port) : index(port.index) {}
+
+double sonar::distance(distanceUnits units) {
+  sim::Guard guard;
+  double inches = sim::sonarInches();
+  return units == distanceUnits::mm   ? inches * 25.4
+         : units == distanceUnits::cm ? inches * 2.54
+                                      : inches;
+}
+
+line::line(triport::port &port) : index(port.index) {}
+
+int32_t line::value(analogUnits units) {
+  sim::Guard guard;
+  int32_t raw = sim::lineReflection();
+  return units == analogUnits::range8bit    ? raw >> 4
+         : units == analogUnits::range10bit ? raw >> 2
+         : units == analogUnits::pct        ? raw * 100 / 4095
+         : units == analogUnits::mV         ? raw * 5000 / 4095
+                                            : raw;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                          Competition and tasks                            */
+/*---------------------------------------------------------------------------*/
+
+void competition::autonomous(void (*callback)(void)) {
+  sim::competitionCallback(true, callback);
+}
+
+void competition::drivercontrol(void (*callback)(void)) {
+  sim::competitionCallback(false, callback);
+}
+
+bool competition::isEnabled() { return true; }
+
+bool competition::isAutonomous() {
+  return sim::inPeriod(sim::autonomousPeriod) ||
+         sim::inPeriod(sim::skillsPeriod);
+}
+
+bool competition::isDriverControl() {
+  return sim::inPeriod(sim::driverPeriod);
+}
+
+task::task(int (*callback)(void)) {
+  sim::startTask(callback, taskPriorityNormal);
+}
+
+task::task(int (*callback)(void), int32_t priority) {
+  sim::startTask(callback, priority);
+}
+
+void task::sleep(uint32_t time) { sim::sleepMs(time); }
+void task::yield() { sim::sleepMs(0); }
+
+void this_thread::sleep_for(uint32_t time) { sim::sleepMs(time); }
+void this_thread::yield() { sim::sleepMs(0); }
+
+// Only one task runs at a time, so a flag is enough; a task that finds it
+// held lets the others run until whoever holds it lets go
+mutex::mutex() { handle = new bool(false); }
+mutex::~mutex() { delete (bool *)handle; }
+
+void mutex::lock() {
+  while (!try_lock())
+    sim::sleepMs(0);
+}
+
+bool mutex::try_lock() {
+  bool &held = *(bool *)handle;
+  if (held)
+    return false;
+  held = true;
+  return true;
+}
+
+void mutex::unlock() { *(bool *)handle = false; }
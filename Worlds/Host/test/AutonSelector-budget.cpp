@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+// The program itself, with its main out of the way of this file's
+#define main programMain
+#include "../../AutonSelector/src/main.cpp"
+#undef main
+
+/*---------------------------------------------------------------------------*/
+/*                           AutonSelector Budget                            */
+/*                                                                           */
+/*  Runs FrontPark, which has skippable settle pauses and a critical park,   */
+/*  through the Executor with the program's own estimates and a runner that  */
+/*  takes each step's estimate, or stops at its deadline. The full budget    */
+/*  runs every step. A short budget has to drop skippable steps, and never   */
+/*  any other, and one far too short has to cut steps as well. However       */
+/*  short, the time held back for the park has to let it run in full, and    */
+/*  the routine has to be over within the budget.                            */
+/*---------------------------------------------------------------------------*/
+
+// How far past the budget a run may end: the runner's last sleep and every
+// call in between cost a little simulated time
+static const uint32_t slackMs = 10;
+
+static int runsOptional, runsCritical, runsCut;
+static bool parkFull;
+static int failures;
+
+static void fail(const char *scenario, const char *what, long got,
+                 long expected) {
+  failures++;
+  printf("FAIL %s: %s is %ld, expected %ld\n", scenario, what, got, expected);
+}
+
+// Takes as long as the program expects the step to, or until its deadline
+static StepOutcome timedStep(const Step &step, uint32_t deadlineMs) {
+  uint32_t takes = estimateStep(step);
+  int32_t left = (int32_t)(deadlineMs - vex::timer::system());
+  bool full = left >= (int32_t)takes;
+  if (takes > 0)
+    vex::task::sleep(full ? takes : std::max(left, (int32_t)0));
+
+  runsOptional += (step.flags & optionalStep) != 0;
+  runsCut += !full;
+  if (step.flags & criticalStep) {
+    runsCritical++;
+    parkFull = full;
+  }
+  return full ? stepDone : stepCut;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                Scenarios                                  */
+/*---------------------------------------------------------------------------*/
+
+enum Shortfall {
+  noneShort,   // every step runs
+  pausesShort, // skippable steps are dropped
+  farShort     // steps are cut as well
+};
+
+struct Scenario {
+  const char *name;
+  Alliance alliance;
+  // the budget is this much short of the expected total and the margin
+  // held back for the park
+  int32_t shortMs;
+  Shortfall shortfall;
+};
+
+static const Scenario scenarios[] = {
+    {"full red", redAlliance, -1000, noneShort},
+    {"full blue", blueAlliance, -1000, noneShort},
+    {"300 ms short red", redAlliance, 300, pausesShort},
+    {"300 ms short blue", blueAlliance, 300, pausesShort},
+    {"7 s short red", redAlliance, 7000, farShort},
+    {"7 s short blue", blueAlliance, 7000, farShort},
+};
+
+static const int scenarioCount = sizeof(scenarios) / sizeof(Scenario);
+
+static void check(const Scenario &s) {
+  const Routine &routine = routines[routineIndex("FrontPark")];
+  static Executor budgeted(timedStep, estimateStep);
+
+  // what the alliance runs of the table
+  int optional = 0, count = 0;
+  for (int i = 0; i < routine.count; i++) {
+    Step step;
+    if (!mirrorStep(routine.steps[i], s.alliance, false, step))
+      continue;
+    count++;
+    optional += (step.flags & optionalStep) != 0;
+  }
+
+  runsOptional = runsCritical = runsCut = 0;
+  parkFull = false;
+  if (!budgeted.prepare(routine, s.alliance)) {
+    fail(s.name, "prepared", 0, 1);
+    return;
+  }
+  uint32_t budget =
+      budgeted.expectedTotal() + Executor::criticalMargin - s.shortMs;
+  budgeted.run(budget);
+
+  int skipped = budgeted.count(stepSkipped);
+  if (s.shortfall == noneShort && skipped != 0)
+    fail(s.name, "steps skipped", skipped, 0);
+  if (s.shortfall != noneShort && skipped == 0)
+    fail(s.name, "steps skipped", skipped, 1);
+
+  // only skippable steps are ever dropped
+  if (skipped != optional - runsOptional)
+    fail(s.name, "skippable steps dropped", optional - runsOptional,
+         skipped);
+  if (budgeted.count(stepDone) + budgeted.count(stepCut) + skipped != count)
+    fail(s.name, "steps accounted for",
+         budgeted.count(stepDone) + budgeted.count(stepCut) + skipped, count);
+
+  if (s.shortfall == noneShort && runsCut != 0)
+    fail(s.name, "steps cut", runsCut, 0);
+  if (s.shortfall == farShort && runsCut == 0)
+    fail(s.name, "steps cut", runsCut, 1);
+
+  // the park always runs in full, inside the budget
+  if (runsCritical != 1 || !parkFull)
+    fail(s.name, "full parks", parkFull ? runsCritical : 0, 1);
+  if (budgeted.elapsed() > budget + slackMs)
+    fail(s.name, "ms taken", budgeted.elapsed(), budget);
+
+  printf("%s: %u of %u ms, %d skipped, %d cut, park %s\n", s.name,
+         (unsigned)budgeted.elapsed(), (unsigned)budget, skipped, runsCut,
+         parkFull ? "in full" : "cut");
+}
+
+static int runScenarios() {
+  for (int i = 0; i < scenarioCount; i++)
+    check(scenarios[i]);
+  return 0;
+}
+
+static bool keepGoing(double) { return true; }
+
+int main() {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start.x = 72;
+  options.start.y = 72;
+  options.start.heading = 0;
+  options.sdDirectory = NULL;
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  sim::start(options);
+  sim::startTask(runScenarios, 7);
+  sim::run(keepGoing);
+
+  printf("%d scenarios, %d failures\n", scenarioCount, failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+// The program itself, with its main out of the way of this file's
+#define main programMain
+#include "../../AutonSelector/src/main.cpp"
+#undef main
+
+/*---------------------------------------------------------------------------*/
+/*                           AutonSelector Groups                            */
+/*                                                                           */
+/*  Runs a drive and an arm move as one group through AutonSelector's own    */
+/*  runStep, so forward() and armMove() on the plant are what see the group  */
+/*  join, under each join rule. The drive is the 19 in of the far routines'  */
+/*  group. A step the join rule waits for has to finish where it was going,  */
+/*  a step it does not wait for has to be cut short, and stop when the group */
+/*  joins rather than run on to its own end.                                 */
+/*---------------------------------------------------------------------------*/
+
+static const sim::Pose start = {72, 36, 0};
+
+static const float driveInches = 19;
+static const double travelTolerance = 1; // in
+static const double armTolerance = 0.02; // revs
+
+// How long after the group joins a step still running may stop: the
+// executor looks every groupPoll ms, and the runners every motionSlice
+static const uint32_t joinSlackMs = Executor::groupPoll + motionSlice + 10;
+
+struct Ran {
+  StepOutcome outcome;
+  uint32_t atMs; // from the start of the run
+};
+
+static Ran driveRan, armRan;
+static uint32_t runStartedAt;
+static int failures;
+
+static void fail(const char *scenario, const char *what, double got,
+                 double expected) {
+  failures++;
+  printf("FAIL %s: %s is %.3f, expected %.3f\n", scenario, what, got,
+         expected);
+}
+
+// The program's runner, noting how each step came out and when
+static StepOutcome recordStep(const Step &step, uint32_t deadlineMs) {
+  StepOutcome outcome = runStep(step, deadlineMs);
+  Ran &ran = step.kind == moveStep ? driveRan : armRan;
+  ran.outcome = outcome;
+  ran.atMs = vex::timer::system() - runStartedAt;
+  return outcome;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                Scenarios                                  */
+/*---------------------------------------------------------------------------*/
+
+struct Scenario {
+  const char *name;
+  JoinRule join;
+  bool armFirst;
+  float armRpm; // 60 gets there well before the drive, 10 after it
+  StepOutcome driveOutcome;
+  StepOutcome armOutcome;
+};
+
+static const Scenario scenarios[] = {
+    {"joinAll", joinAll, false, 10, stepDone, stepDone},
+    {"joinAny", joinAny, false, 60, stepCut, stepDone},
+    {"joinFirst drive first", joinFirst, false, 10, stepDone, stepCut},
+    {"joinFirst arm first", joinFirst, true, 60, stepCut, stepDone},
+};
+
+static const int scenarioCount = sizeof(scenarios) / sizeof(Scenario);
+
+// Back on the start tile with the arm down and every motor let go
+static void resetRobot() {
+  sim::Guard guard;
+  for (int i = 0; i < sim::portCount; i++)
+    sim::motors[i].mode = sim::motorCoasting;
+  sim::resetPlant(start);
+}
+
+static double travelled() {
+  sim::Guard guard;
+  sim::Pose now = sim::pose();
+  return hypot(now.x - start.x, now.y - start.y);
+}
+
+static void check(const Scenario &s) {
+  const Step move = moveBy(driveInches, 70, 50);
+  const Step lift = armBy(0.22, s.armRpm);
+  const Step steps[] = {together(2, s.join), s.armFirst ? lift : move,
+                        s.armFirst ? move : lift};
+  Routine routine = {s.name, steps, sizeof(steps) / sizeof(Step),
+                     redAlliance};
+  static Executor grouped(recordStep, estimateStep, recoverStep);
+
+  resetRobot();
+  driveRan.outcome = armRan.outcome = stepPending;
+  if (!grouped.prepare(routine, redAlliance)) {
+    fail(s.name, "prepared", 0, 1);
+    return;
+  }
+  runStartedAt = vex::timer::system();
+  grouped.run(autonomousBudget);
+  vex::task::sleep(300); // let the drive come to rest
+
+  double travel = travelled();
+  double armRevs = arm.rotation(vex::rotationUnits::rev);
+  if (driveRan.outcome != s.driveOutcome)
+    fail(s.name, "drive outcome", driveRan.outcome, s.driveOutcome);
+  if (armRan.outcome != s.armOutcome)
+    fail(s.name, "arm outcome", armRan.outcome, s.armOutcome);
+
+  // a step that finished got where it was going, a cut one stopped short
+  if (s.driveOutcome == stepDone &&
+      fabs(travel - driveInches) > travelTolerance)
+    fail(s.name, "drive travel", travel, driveInches);
+  if (s.driveOutcome == stepCut &&
+      (travel < 1 || travel > driveInches - travelTolerance))
+    fail(s.name, "cut drive travel", travel, driveInches / 2);
+  if (s.armOutcome == stepDone && fabs(armRevs - 0.22) > armTolerance)
+    fail(s.name, "arm revs", armRevs, 0.22);
+  if (s.armOutcome == stepCut && (armRevs < 0.01 || armRevs > 0.2))
+    fail(s.name, "cut arm revs", armRevs, 0.11);
+
+  // a cut step stops as the group joins on the other one
+  const Ran &cut = s.driveOutcome == stepCut ? driveRan : armRan;
+  const Ran &done = s.driveOutcome == stepCut ? armRan : driveRan;
+  if (cut.outcome == stepCut && cut.atMs > done.atMs + joinSlackMs)
+    fail(s.name, "cut step stopped at ms", cut.atMs, done.atMs);
+
+  printf("%s: drive %s %.1f in at %u ms, arm %s %.3f revs at %u ms\n", s.name,
+         driveRan.outcome == stepDone ? "done" : "cut", travel,
+         (unsigned)driveRan.atMs, armRan.outcome == stepDone ? "done" : "cut",
+         armRevs, (unsigned)armRan.atMs);
+}
+
+static int runScenarios() {
+  setStoppingModes();
+  for (int i = 0; i < scenarioCount; i++)
+    check(scenarios[i]);
+  return 0;
+}
+
+static bool keepGoing(double) { return true; }
+
+int main() {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start = start;
+  options.sdDirectory = NULL;
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  sim::start(options);
+  sim::startTask(runScenarios, 7);
+  sim::run(keepGoing);
+
+  printf("%d scenarios, %d failures\n", scenarioCount, failures);
+  return failures > 0 ? 1 : 0;
+}
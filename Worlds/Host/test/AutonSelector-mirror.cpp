@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+// The program itself, with its main out of the way of this file's
+#define main programMain
+#include "../../AutonSelector/src/main.cpp"
+#undef main
+
+/*---------------------------------------------------------------------------*/
+/*                           AutonSelector Mirror                            */
+/*                                                                           */
+/*  Runs every routine through the Executor for each alliance the selector   */
+/*  can pick it for, with a runner that only notes the steps it is given.    */
+/*  A table run for the alliance it is written for has to run as written,    */
+/*  less the other alliance's steps. Run for the other alliance, turns and   */
+/*  pivots have to change sign, and steps given for one alliance have to run */
+/*  as written on theirs and not at all on the other. The front routines'    */
+/*  turns are also checked against the numbers they have to come out as, and */
+/*  no selector combination may pick a far table for the other alliance.     */
+/*---------------------------------------------------------------------------*/
+
+static const int maxRun = 128;
+
+static Step ran[maxRun];
+static bool matched[maxRun];
+static int ranCount;
+static int failures;
+
+static void fail(const char *run, const char *what, int index, double got,
+                 double expected) {
+  failures++;
+  printf("FAIL %s: %s %d is %g, expected %g\n", run, what, index, got,
+         expected);
+}
+
+static StepOutcome noteStep(const Step &step, uint32_t) {
+  if (ranCount < maxRun)
+    ran[ranCount] = step;
+  ranCount++;
+  return stepDone;
+}
+
+static const char *allianceName(Alliance alliance) {
+  return alliance == blueAlliance ? "blue" : "red";
+}
+
+// Runs routine for alliance and checks each step against its table
+static void checkRun(const Routine &routine, Alliance alliance) {
+  char name[48];
+  snprintf(name, sizeof(name), "%s %s", routine.name, allianceName(alliance));
+  static Executor noting(noteStep, estimateStep);
+
+  ranCount = 0;
+  if (!noting.prepare(routine, alliance)) {
+    fail(name, "prepared", 0, 0, 1);
+    return;
+  }
+  noting.run(autonomousBudget);
+
+  bool mirrored = routine.alliance != alliance;
+  int other = alliance == blueAlliance ? redOnlyStep : blueOnlyStep;
+  for (int j = 0; j < maxRun; j++)
+    matched[j] = false;
+
+  // the group step itself is the executor's, only its members are run
+  int n = 0;
+  for (int i = 0; i < routine.count; i++) {
+    const Step &written = routine.steps[i];
+    if ((written.flags & other) || written.kind == groupStep)
+      continue;
+
+    // the first step not yet matched of the same kind and size, since a
+    // group's members start in their own tasks
+    const Step *got = NULL;
+    for (int j = 0; j < ranCount && j < maxRun && got == NULL; j++) {
+      const Step &r = ran[j];
+      if (!matched[j] && r.kind == written.kind && r.flags == written.flags &&
+          (r.value == written.value || r.value == -written.value)) {
+        matched[j] = true;
+        got = &r;
+      }
+    }
+    if (got == NULL) {
+      fail(name, "runs of table step", i, 0, 1);
+      continue;
+    }
+
+    bool fixed = written.flags & (redOnlyStep | blueOnlyStep);
+    bool turning = written.kind == turnStep || written.kind == pivotStep;
+    float expected =
+        mirrored && turning && !fixed ? -written.value : written.value;
+    if (got->value != expected)
+      fail(name, "value of table step", i, got->value, expected);
+    if (got->speed != written.speed)
+      fail(name, "speed of table step", i, got->speed, written.speed);
+    if (got->minimum != written.minimum)
+      fail(name, "minimum of table step", i, got->minimum, written.minimum);
+    n++;
+  }
+  if (ranCount != n)
+    fail(name, "steps run", 0, ranCount, n);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                Front turns                                */
+/*---------------------------------------------------------------------------*/
+
+struct Turns {
+  const char *routine;
+  Alliance alliance;
+  int count;
+  float degrees[8]; // of the turn steps, in order
+};
+
+// The red turns as written. Blue runs its own first turns, and the shared
+// ones the other way.
+static const Turns frontTurns[] = {
+    {"FrontPark", redAlliance, 4, {-275, 275, 275, -275}},
+    {"FrontPark", blueAlliance, 4, {282, -275, -275, 275}},
+    {"FrontNP", redAlliance, 5, {-275, 270, 177, -372, -9}},
+    {"FrontNP", blueAlliance, 5, {282, -275, -177, 378, 9}},
+};
+
+static void checkTurns(const Turns &t) {
+  char name[48];
+  snprintf(name, sizeof(name), "%s %s turns", t.routine,
+           allianceName(t.alliance));
+  static Executor noting(noteStep, estimateStep);
+
+  ranCount = 0;
+  noting.prepare(routines[routineIndex(t.routine)], t.alliance);
+  noting.run(autonomousBudget);
+
+  int turns = 0;
+  for (int i = 0; i < ranCount && i < maxRun; i++) {
+    if (ran[i].kind != turnStep)
+      continue;
+    if (turns < t.count && ran[i].value != t.degrees[turns])
+      fail(name, "degrees of turn", turns, ran[i].value, t.degrees[turns]);
+    turns++;
+  }
+  if (turns != t.count)
+    fail(name, "turns", 0, turns, t.count);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                Selections                                 */
+/*---------------------------------------------------------------------------*/
+
+static bool isFront(int routine) {
+  return routine == routineIndex("FrontPark") ||
+         routine == routineIndex("FrontNP");
+}
+
+static int runChecks() {
+  // every routine and alliance the selector can pick, each once
+  bool checked[routineCount][2] = {};
+  for (int mask = 0; mask < selectorMasks; mask++) {
+    const Selection &s = selections[mask];
+    if (s.routine < 0)
+      continue;
+    const Routine &routine = routines[s.routine];
+    if (s.alliance != routine.alliance && !isFront(s.routine))
+      fail(routine.name, "far table mirrored, selector mask", mask,
+           s.alliance, routine.alliance);
+    if (checked[s.routine][s.alliance])
+      continue;
+    checked[s.routine][s.alliance] = true;
+    checkRun(routine, s.alliance);
+  }
+
+  for (int r = 0; r < routineCount; r++)
+    if (!checked[r][redAlliance] && !checked[r][blueAlliance])
+      fail(routines[r].name, "selections that pick routine", r, 0, 1);
+
+  int turnRuns = sizeof(frontTurns) / sizeof(Turns);
+  for (int i = 0; i < turnRuns; i++)
+    checkTurns(frontTurns[i]);
+  return 0;
+}
+
+static bool keepGoing(double) { return true; }
+
+int main() {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start.x = 72;
+  options.start.y = 72;
+  options.start.heading = 0;
+  options.sdDirectory = NULL;
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  sim::start(options);
+  sim::startTask(runChecks, 7);
+  sim::run(keepGoing);
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
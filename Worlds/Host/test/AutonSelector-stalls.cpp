@@ -0,0 +1,198 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+// The program itself, with its main out of the way of this file's
+#define main programMain
+#include "../../AutonSelector/src/main.cpp"
+#undef main
+
+/*---------------------------------------------------------------------------*/
+/*                           AutonSelector Stalls                            */
+/*                                                                           */
+/*  Runs short routines through AutonSelector's own runStep and recoverStep  */
+/*  on the plant, with something in the way: a drive into the field wall,    */
+/*  and an arm move past a jam. Against the wall, tires that grip hard stop  */
+/*  the drive, which stalls, and tires that slip keep it turning until it    */
+/*  times out. The stuck step has to be given up on that way, the drive has  */
+/*  to back off backOffDistance from the wall while the jammed arm just      */
+/*  holds, and the routine has to carry on and drive its critical park in    */
+/*  full.                                                                    */
+/*---------------------------------------------------------------------------*/
+
+static const double travelTolerance = 1; // in
+static const double backOffTolerance = 0.75; // in
+
+static const int maxSteps = 8;
+
+struct Ran {
+  sim::Pose from, to;
+  bool recovered;
+  sim::Pose backedOffTo;
+};
+
+static Ran ran[maxSteps];
+static int stepsRun;
+static int failures;
+
+static void fail(const char *scenario, const char *what, double got,
+                 double expected) {
+  failures++;
+  printf("FAIL %s: %s is %.2f, expected %.2f\n", scenario, what, got,
+         expected);
+}
+
+static sim::Pose where() {
+  sim::Guard guard;
+  return sim::pose();
+}
+
+static double apart(const sim::Pose &a, const sim::Pose &b) {
+  return hypot(a.x - b.x, a.y - b.y);
+}
+
+// The program's runner and recovery, noting where the robot was around each
+static StepOutcome recordStep(const Step &step, uint32_t deadlineMs) {
+  Ran &r = ran[stepsRun < maxSteps ? stepsRun : maxSteps - 1];
+  r.recovered = false;
+  r.from = where();
+  StepOutcome outcome = runStep(step, deadlineMs);
+  r.to = where();
+  stepsRun++;
+  return outcome;
+}
+
+static void recordRecovery(const Step &step, uint32_t deadlineMs) {
+  recoverStep(step, deadlineMs);
+  Ran &r = ran[stepsRun - 1];
+  r.recovered = true;
+  r.backedOffTo = where();
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                Scenarios                                  */
+/*---------------------------------------------------------------------------*/
+
+static const float parkInches = 20;
+
+// 30 in toward a wall about 15 in ahead, then back to park
+static const Step intoWall[] = {
+    moveBy(30, 100, 60),
+    waitFor(100),
+    critical(moveBy(-parkInches, 100, 50)),
+};
+
+// The arm is jammed at 0.05 revs, so it never gets up to 0.22
+static const Step jammedArm[] = {
+    armBy(0.22, 25),
+    waitFor(100),
+    critical(moveBy(parkInches, 100, 50)),
+};
+
+struct Scenario {
+  const char *name;
+  const Step *steps;
+  int count;
+  sim::Pose start;
+  double grip;       // of the tires
+  double armHighest; // revs the arm is stopped at
+  StepOutcome stuck; // how the first step is given up on
+  bool backsOff;
+};
+
+static const Scenario scenarios[] = {
+    {"wall, wheels held", intoWall, sizeof(intoWall) / sizeof(Step),
+     {72, 120, 0}, 10, 0.5, stepStalled, true},
+    {"wall, wheels slipping", intoWall, sizeof(intoWall) / sizeof(Step),
+     {72, 120, 0}, 3, 0.5, stepTimedOut, true},
+    {"jammed arm", jammedArm, sizeof(jammedArm) / sizeof(Step), {72, 36, 0},
+     0.9, 0.05, stepStalled, false},
+};
+
+static const int scenarioCount = sizeof(scenarios) / sizeof(Scenario);
+
+// On the start tile with the arm down and every motor let go
+static void resetRobot(const sim::Pose &start) {
+  sim::Guard guard;
+  for (int i = 0; i < sim::portCount; i++)
+    sim::motors[i].mode = sim::motorCoasting;
+  sim::resetPlant(start);
+}
+
+static void check(const Scenario &s) {
+  Routine routine = {s.name, s.steps, s.count, redAlliance};
+  static Executor stalling(recordStep, estimateStep, recordRecovery);
+
+  sim::setParameter("grip", s.grip);
+  sim::setParameter("armHighest", s.armHighest);
+  resetRobot(s.start);
+  stepsRun = 0;
+  if (!stalling.prepare(routine, redAlliance)) {
+    fail(s.name, "prepared", 0, 1);
+    return;
+  }
+  stalling.run(autonomousBudget);
+  vex::task::sleep(300); // let the drive come to rest
+
+  // the stuck step was given up on, and only that one
+  if (stalling.count(s.stuck) != 1)
+    fail(s.name, s.stuck == stepStalled ? "steps stalled" : "steps timed out",
+         stalling.count(s.stuck), 1);
+  if (stepsRun != s.count)
+    fail(s.name, "steps run", stepsRun, s.count);
+  if (!ran[0].recovered)
+    fail(s.name, "stuck step recovered", 0, 1);
+
+  // the drive backs away from the wall, the arm does not move the robot
+  double backedOff = apart(ran[0].to, ran[0].backedOffTo);
+  double expected = s.backsOff ? backOffDistance : 0;
+  if (fabs(backedOff - expected) > backOffTolerance)
+    fail(s.name, "backed off in", backedOff, expected);
+  if (s.backsOff && ran[0].backedOffTo.y > ran[0].to.y)
+    fail(s.name, "backed off toward the wall", ran[0].backedOffTo.y,
+         ran[0].to.y);
+
+  // and the routine went on to park in full
+  const Ran &park = ran[stepsRun - 1];
+  double parked = apart(park.from, where());
+  if (stalling.count(stepDone) != s.count - 1)
+    fail(s.name, "steps done", stalling.count(stepDone), s.count - 1);
+  if (fabs(parked - parkInches) > travelTolerance)
+    fail(s.name, "park travel", parked, parkInches);
+
+  printf("%s: %s, backed off %.1f in, parked %.1f in, over in %u ms\n",
+         s.name, stalling.count(stepStalled) ? "stalled" : "timed out",
+         backedOff, parked, (unsigned)stalling.elapsed());
+}
+
+static int runScenarios() {
+  setStoppingModes();
+  for (int i = 0; i < scenarioCount; i++)
+    check(scenarios[i]);
+  return 0;
+}
+
+static bool keepGoing(double) { return true; }
+
+int main() {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start = scenarios[0].start;
+  options.sdDirectory = NULL;
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  sim::start(options);
+  sim::startTask(runScenarios, 7);
+  sim::run(keepGoing);
+
+  printf("%d scenarios, %d failures\n", scenarioCount, failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+#include "../../AutonSelector/include/executor.h"
+
+/*---------------------------------------------------------------------------*/
+/*                              Executor Test                                */
+/*                                                                           */
+/*  Runs AutonSelector's Executor on the simulator's tasks with a stand-in   */
+/*  step runner: every step is a wait of its value in ms, which gives up at  */
+/*  its deadline or once its group has joined, like the real runners. The    */
+/*  same group of a 300, a 100 and a 500 ms step, followed by a 50 ms step,  */
+/*  is run under each join rule and then against a budget it cannot finish   */
+/*  in. Each run checks which steps were done and which were cut, when each  */
+/*  one stopped, and the time prepare() expects the group to take.           */
+/*---------------------------------------------------------------------------*/
+
+// How late a step may stop: the executor looks at a group every groupPoll
+// ms, and every call in between costs a little simulated time
+static const uint32_t slackMs = Executor::groupPoll + 5;
+
+static const int stepIds = 5; // the group is step 0, then the ids 1 to 4
+
+struct Stopped {
+  StepOutcome outcome;
+  uint32_t atMs; // from the start of the run
+};
+
+static Stopped stopped[stepIds];
+static uint32_t runStartedAt;
+static int failures;
+
+static void fail(const char *scenario, const char *what, int id, long got,
+                 long expected) {
+  failures++;
+  printf("FAIL %s: step %d %s is %ld, expected %ld\n", scenario, id, what,
+         got, expected);
+}
+
+// Steps carry their id in minimum
+static StepOutcome runStep(const Step &step, uint32_t deadlineMs) {
+  int id = (int)step.minimum;
+  uint32_t start = vex::timer::system();
+  StepOutcome outcome = stepDone;
+  while (vex::timer::system() - start < (uint32_t)step.value) {
+    if ((int32_t)(deadlineMs - vex::timer::system()) <= 0 || groupJoined()) {
+      outcome = stepCut;
+      break;
+    }
+    vex::task::sleep(1);
+  }
+  stopped[id].outcome = outcome;
+  stopped[id].atMs = vex::timer::system() - runStartedAt;
+  return outcome;
+}
+
+static uint32_t estimate(const Step &step) { return (uint32_t)step.value; }
+
+static Step waitWithId(int id, float ms) {
+  return Step{waitStep, 0, 0, ms, 0, (float)id};
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                Scenarios                                  */
+/*---------------------------------------------------------------------------*/
+
+struct Scenario {
+  const char *name;
+  JoinRule join;
+  uint32_t budgetMs;
+  uint32_t expectedMs;           // what prepare() works out for the table
+  StepOutcome outcomes[stepIds]; // of the steps with ids 1 to 4
+  uint32_t stoppedAt[stepIds];   // ms from the start
+};
+
+static const Scenario scenarios[] = {
+    {"joinAll",
+     joinAll,
+     15000,
+     550,
+     {stepPending, stepDone, stepDone, stepDone, stepDone},
+     {0, 300, 100, 500, 550}},
+    {"joinAny",
+     joinAny,
+     15000,
+     150,
+     {stepPending, stepCut, stepDone, stepCut, stepDone},
+     {0, 100, 100, 100, 150}},
+    {"joinFirst",
+     joinFirst,
+     15000,
+     350,
+     {stepPending, stepDone, stepDone, stepCut, stepDone},
+     {0, 300, 100, 300, 350}},
+    // the budget runs out in the group, and the step after gets no time
+    {"joinAll over budget",
+     joinAll,
+     200,
+     550,
+     {stepPending, stepCut, stepDone, stepCut, stepCut},
+     {0, 200, 100, 200, 200}},
+};
+
+static const int scenarioCount = sizeof(scenarios) / sizeof(Scenario);
+
+static void check(const Scenario &s) {
+  const Step steps[] = {together(3, s.join), waitWithId(1, 300),
+                        waitWithId(2, 100), waitWithId(3, 500),
+                        waitWithId(4, 50)};
+  Routine routine = {s.name, steps, sizeof(steps) / sizeof(Step),
+                     redAlliance};
+  static Executor executor(runStep, estimate);
+
+  for (int id = 0; id < stepIds; id++)
+    stopped[id].outcome = stepPending;
+  if (!executor.prepare(routine, redAlliance)) {
+    fail(s.name, "prepared", 0, 0, 1);
+    return;
+  }
+  if (executor.expectedTotal() != s.expectedMs)
+    fail(s.name, "expected ms", 0, executor.expectedTotal(), s.expectedMs);
+
+  runStartedAt = vex::timer::system();
+  executor.run(s.budgetMs);
+
+  int done = 0, cut = 0;
+  for (int id = 1; id < stepIds; id++) {
+    const Stopped &got = stopped[id];
+    if (got.outcome != s.outcomes[id]) {
+      fail(s.name, "outcome", id, got.outcome, s.outcomes[id]);
+      continue;
+    }
+    done += got.outcome == stepDone;
+    cut += got.outcome == stepCut;
+    if (got.atMs < s.stoppedAt[id] || got.atMs > s.stoppedAt[id] + slackMs)
+      fail(s.name, "stopped at ms", id, got.atMs, s.stoppedAt[id]);
+  }
+
+  // the executor's own record agrees, with the group step itself done
+  if (executor.count(stepDone) != done + 1)
+    fail(s.name, "done count", 0, executor.count(stepDone), done + 1);
+  if (executor.count(stepCut) != cut)
+    fail(s.name, "cut count", 0, executor.count(stepCut), cut);
+  printf("%s: %d done, %d cut, over in %u ms\n", s.name, done, cut,
+         (unsigned)executor.elapsed());
+}
+
+static int runScenarios() {
+  for (int i = 0; i < scenarioCount; i++)
+    check(scenarios[i]);
+  return 0;
+}
+
+static bool keepGoing(double) { return true; }
+
+int main() {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start.x = 72;
+  options.start.y = 72;
+  options.start.heading = 0;
+  options.sdDirectory = NULL;
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  sim::start(options);
+  sim::startTask(runScenarios, 7);
+  sim::run(keepGoing);
+
+  printf("%d scenarios, %d failures\n", scenarioCount, failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../Skills/include/ringbuffer.h"
+
+/*---------------------------------------------------------------------------*/
+/*                            Ring Buffer Test                               */
+/*                                                                           */
+/*  Checks Skills' RingBuffer on its own, then under load: a producer and a  */
+/*  consumer thread push and pop a million samples through a small ring so   */
+/*  it wraps and fills over and over. A thread that finds the ring full or   */
+/*  empty sleeps, so the other gets the core on a single core host too.      */
+/*  Real threads are used rather than the simulator's tasks, which only      */
+/*  switch inside vex calls and so could never catch a push or pop half      */
+/*  done.                                                                    */
+/*                                                                           */
+/*  Every sample carries its sequence number and words worked out from it.   */
+/*  The consumer has to see every pushed sample exactly once, in order, with */
+/*  all its words matching, and the drops the ring counts have to be the     */
+/*  pushes that were refused.                                                */
+/*---------------------------------------------------------------------------*/
+
+struct Sample {
+  uint32_t sequence;
+  uint32_t words[15]; // big enough that a torn copy shows
+};
+
+static const uint32_t sampleCount = 1000000;
+
+static RingBuffer<Sample, 16> ring;
+static uint32_t refused;
+static int failures;
+
+static void fail(const char *what, uint32_t sequence) {
+  if (failures++ < 10)
+    printf("FAIL %s at %u\n", what, sequence);
+}
+
+static Sample sampleFor(uint32_t sequence) {
+  Sample s;
+  s.sequence = sequence;
+  for (int i = 0; i < 15; i++)
+    s.words[i] = sequence * 2654435761u + i;
+  return s;
+}
+
+static bool intact(const Sample &s) {
+  for (int i = 0; i < 15; i++) {
+    if (s.words[i] != s.sequence * 2654435761u + i)
+      return false;
+  }
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                                One thread                                 */
+/*---------------------------------------------------------------------------*/
+
+static void checkAlone() {
+  RingBuffer<Sample, 4> small;
+  Sample s;
+  if (!small.empty() || small.count() != 0 || small.pop(s))
+    fail("new ring not empty", 0);
+  if (small.capacity() != 3)
+    fail("capacity", small.capacity());
+
+  // round and round, so head and tail wrap many times
+  uint32_t next = 0, expected = 0;
+  for (int lap = 0; lap < 100; lap++) {
+    while (small.push(sampleFor(next)))
+      next++;
+    if (small.count() != small.capacity())
+      fail("full count", small.count());
+    if (small.dropped() != (uint32_t)lap + 1)
+      fail("full push not counted", small.dropped());
+
+    while (small.pop(s)) {
+      if (s.sequence != expected++ || !intact(s))
+        fail("alone order", s.sequence);
+    }
+    if (!small.empty() || small.count() != 0)
+      fail("drained ring not empty", lap);
+  }
+  if (expected != next)
+    fail("alone count", expected);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                               Two threads                                 */
+/*---------------------------------------------------------------------------*/
+
+static void *produce(void *) {
+  uint32_t sequence = 0;
+  while (sequence < sampleCount) {
+    if (ring.push(sampleFor(sequence))) {
+      sequence++;
+    } else {
+      refused++;
+      usleep(1);
+    }
+  }
+  return NULL;
+}
+
+static void *consume(void *) {
+  uint32_t expected = 0;
+  Sample s;
+  while (expected < sampleCount) {
+    if (!ring.pop(s)) {
+      usleep(1);
+      continue;
+    }
+    if (s.sequence != expected)
+      fail("out of order", s.sequence);
+    else if (!intact(s))
+      fail("torn", s.sequence);
+    expected = s.sequence + 1;
+  }
+  return NULL;
+}
+
+int main() {
+  checkAlone();
+
+  pthread_t producer, consumer;
+  pthread_create(&consumer, NULL, consume, NULL);
+  pthread_create(&producer, NULL, produce, NULL);
+  pthread_join(producer, NULL);
+  pthread_join(consumer, NULL);
+
+  Sample s;
+  if (!ring.empty() || ring.pop(s))
+    fail("left over", ring.count());
+  if (ring.dropped() != refused)
+    fail("drops", ring.dropped());
+
+  printf("%u samples, %u refused while full, %d failures\n", sampleCount,
+         refused, failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#include "../../AutonSelector/include/routinefile.h"
+#include "../../AutonSelector/include/routines.h"
+
+/*---------------------------------------------------------------------------*/
+/*                             Routine File Test                             */
+/*                                                                           */
+/*  make test compiles every table in routines.h with CompileRoutine.py into */
+/*  build/routines/<routine>.rtn, the SD card here. Each one has to load     */
+/*  back through RoutineFile into the same steps as the built in table. Then */
+/*  copies of them are broken one way at a time, cut short or with a number  */
+/*  out of range, and each has to be refused with the reason the warm-up     */
+/*  screen would show.                                                       */
+/*---------------------------------------------------------------------------*/
+
+static const char *sdDirectory = "build/routines";
+
+static vex::brain brain;
+static RoutineFile file;
+static int failures;
+
+static void fail(const char *name, const char *what, double got,
+                 double expected) {
+  failures++;
+  printf("FAIL %s: %s is %g, expected %g\n", name, what, got, expected);
+}
+
+static void checkRoundTrip(const Routine &table) {
+  char fileName[32];
+  snprintf(fileName, sizeof(fileName), "%s.rtn", table.name);
+  if (!file.load(brain, fileName, table.name)) {
+    failures++;
+    printf("FAIL %s: refused, %s\n", fileName, file.why());
+    return;
+  }
+
+  const Routine &loaded = file.routine();
+  if (loaded.alliance != table.alliance)
+    fail(fileName, "alliance", loaded.alliance, table.alliance);
+  if (loaded.count != table.count) {
+    fail(fileName, "steps", loaded.count, table.count);
+    return;
+  }
+  for (int i = 0; i < table.count; i++) {
+    const Step &got = loaded.steps[i], &want = table.steps[i];
+    if (got.kind != want.kind || got.flags != want.flags ||
+        got.expectedMs != want.expectedMs)
+      fail(fileName, "kind and flags differ at step", i, i);
+    // values are stored in thousandths
+    if (fabs(got.value - want.value) > 0.0005)
+      fail(fileName, "value", got.value, want.value);
+    if (got.speed != want.speed)
+      fail(fileName, "speed", got.speed, want.speed);
+    if (got.minimum != want.minimum)
+      fail(fileName, "minimum", got.minimum, want.minimum);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/*                               Broken files                                */
+/*---------------------------------------------------------------------------*/
+
+static uint8_t data[RoutineFile::headerSize +
+                    RoutineFile::maxSteps * RoutineFile::stepSize];
+
+static uint8_t *stepAt(int i) {
+  return data + RoutineFile::headerSize + i * RoutineFile::stepSize;
+}
+
+static void put16(uint8_t *p, uint16_t x) {
+  p[0] = x & 0xff;
+  p[1] = x >> 8;
+}
+
+static void put32(uint8_t *p, int32_t x) {
+  for (int i = 0; i < 4; i++)
+    p[i] = ((uint32_t)x >> (8 * i)) & 0xff;
+}
+
+// Where each breakage is made, in the compiled tables
+const int frontParkFlywheel = 0; // flywheelAt(525)
+const int frontParkArm = 1;      // armBy(0.21, 100)
+const int frontParkMove = 3;     // moveBy(37.5, 100, 60)
+const int frontParkWait = 5;     // waitFor(300)
+
+// The arm move, second in redFarNP's drive and arm group
+static int redFarNPArm() {
+  int count = sizeof(redFarNP) / sizeof(Step);
+  for (int i = 0; i + 2 < count; i++)
+    if (redFarNP[i].kind == groupStep && redFarNP[i + 2].kind == armStep)
+      return i + 2;
+  return -1;
+}
+
+struct Breakage {
+  const char *name;
+  const char *from; // routine the file is a copy of
+  const char *why;  // expected reason it is refused
+};
+
+static const Breakage breakages[] = {
+    {"header cut short", "FrontPark", "not a routine"},
+    {"not a routine file", "FrontPark", "not a routine"},
+    {"newer version", "FrontPark", "not a routine"},
+    {"last step cut short", "FrontPark", "wrong length"},
+    {"more steps than fit", "FrontPark", "wrong length"},
+    {"drive off the field", "FrontPark", "step out of range"},
+    {"arm too fast", "FrontPark", "step out of range"},
+    {"group sharing the drive", "RedFarNP", "bad group"},
+    {"wait past the budget", "FrontPark", "too long"},
+    {"target before the flywheel", "FrontPark", "flywheel order"},
+    {"arm past its top", "FrontPark", "arm out of reach"},
+};
+
+static const int breakageCount = sizeof(breakages) / sizeof(Breakage);
+
+// Breaks the copy in data the way b says, returns its new length
+static int32_t breakCopy(int b, int32_t length) {
+  switch (b) {
+  case 0:
+    return RoutineFile::headerSize - 2;
+  case 1:
+    memcpy(data, "RTNX", 4);
+    break;
+  case 2:
+    data[4] = RoutineFile::version + 1;
+    break;
+  case 3:
+    return length - 4;
+  case 4:
+    put16(data + 6, RoutineFile::maxSteps + 1);
+    break;
+  case 5:
+    put32(stepAt(frontParkMove) + 4, 200 * 1000);
+    break;
+  case 6:
+    put16(stepAt(frontParkArm) + 8, 150);
+    break;
+  case 7:
+    stepAt(redFarNPArm())[0] = turnStep;
+    break;
+  case 8:
+    put32(stepAt(frontParkWait) + 4, 14000 * 1000);
+    break;
+  case 9:
+    put16(stepAt(frontParkFlywheel) + 8, flywheelTargetOnly);
+    break;
+  case 10:
+    put32(stepAt(frontParkArm) + 4, 900);
+    break;
+  }
+  return length;
+}
+
+static void checkRefused(int b) {
+  const Breakage &broken = breakages[b];
+  char fileName[32];
+  snprintf(fileName, sizeof(fileName), "%s.rtn", broken.from);
+  int32_t length = brain.SDcard.loadfile(fileName, data, sizeof(data));
+  length = breakCopy(b, length);
+  if (brain.SDcard.savefile("broken.rtn", data, length) != length) {
+    fail(broken.name, "bytes written", 0, length);
+    return;
+  }
+
+  if (file.load(brain, "broken.rtn", broken.from)) {
+    failures++;
+    printf("FAIL %s: loaded, expected %s\n", broken.name, broken.why);
+  } else if (strcmp(file.why(), broken.why) != 0) {
+    failures++;
+    printf("FAIL %s: refused as %s, expected %s\n", broken.name, file.why(),
+           broken.why);
+  } else if (file.ready()) {
+    failures++;
+    printf("FAIL %s: refused but left ready\n", broken.name);
+  }
+}
+
+static int runChecks() {
+  // the layout the breakages expect
+  if (frontPark[frontParkFlywheel].kind != flywheelStep ||
+      frontPark[frontParkArm].kind != armStep ||
+      frontPark[frontParkMove].kind != moveStep ||
+      frontPark[frontParkWait].kind != waitStep || redFarNPArm() < 0)
+    fail("tables", "steps where the breakages expect them", 0, 1);
+
+  for (int i = 0; i < routineCount; i++)
+    checkRoundTrip(routines[i]);
+  for (int b = 0; b < breakageCount; b++)
+    checkRefused(b);
+  printf("%d routines, %d broken files\n", routineCount, breakageCount);
+  return 0;
+}
+
+static bool keepGoing(double) { return true; }
+
+int main() {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start.x = 72;
+  options.start.y = 72;
+  options.start.heading = 0;
+  options.sdDirectory = sdDirectory;
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  sim::start(options);
+  sim::startTask(runChecks, 7);
+  sim::run(keepGoing);
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
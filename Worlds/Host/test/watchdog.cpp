@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+#include "../../Driver/include/watchdog.h"
+
+/*---------------------------------------------------------------------------*/
+/*                              Watchdog Test                                */
+/*                                                                           */
+/*  Runs Driver's Watchdog and periodic jobs on the simulator's tasks, the   */
+/*  way driver control hands over to autonomous: the drive job stops passing */
+/*  when the competition takes its task away, trips its stop, and is then    */
+/*  stopped by autonomous. A motion started after that has to run to the end */
+/*  instead of seeing the drive job's stop. A job that is stuck and still    */
+/*  running must not stop a motion either, and a motion that really stops    */
+/*  moving still has to be stopped.                                          */
+/*---------------------------------------------------------------------------*/
+
+static Watchdog watchdog;
+static int motionWatch;
+static int safeStops;
+static int failures;
+
+static volatile bool driveHung, uiHung;
+
+static void expect(bool ok, const char *what) {
+  if (!ok) {
+    failures++;
+    printf("FAIL %s\n", what);
+  }
+}
+
+static void safeStop() { safeStops++; }
+
+static bool pollWatchdog() {
+  watchdog.poll();
+  return true;
+}
+
+// Hangs the way a job does when its competition task is taken away
+static bool driveStep() {
+  while (driveHung)
+    vex::task::sleep(10);
+  return true;
+}
+
+static bool uiStep() {
+  while (uiHung)
+    vex::task::sleep(10);
+  return true;
+}
+
+// A motion like forward(): moves for passes, checking in as it goes, and
+// returns how many it got through before the watchdog stopped it
+static int runMotion(int passes, bool moving) {
+  double travel = 0;
+  watchdog.start(motionWatch, travel);
+  int pass = 0;
+  while (!watchdog.stopped(motionWatch) && pass < passes) {
+    travel += moving ? 2 : 0;
+    watchdog.progress(motionWatch, travel, 1);
+    yieldControl();
+    pass++;
+  }
+  watchdog.finish(motionWatch);
+  return pass;
+}
+
+static int runChecks() {
+  // driver control: the drive job passes, then its task is taken away
+  int driveWatch = watchdog.watchTask(
+      startTask("drive", controlTask, driveStep, 10), 50, 250);
+  vex::task::sleep(100);
+  driveHung = true;
+  vex::task::sleep(400);
+  expect(watchdog.stopped(driveWatch), "stuck drive job stopped");
+  expect(watchdog.stopped(), "stuck drive job counted as stopped");
+  expect(safeStops == 1, "safe stop ran once");
+
+  // autonomous stops the drive job before it moves
+  stopTask(findTask("drive"));
+  vex::task::sleep(20);
+  expect(!watchdog.stopped(driveWatch), "stopped drive job cleared");
+  expect(!watchdog.stopped(), "nothing counted as stopped");
+  expect(runMotion(200, true) == 200, "motion after the handover finished");
+
+  // a stuck job that is still running stops the robot, not the next motion
+  watchdog.watchTask(startTask("latency display", uiTask, uiStep, 50), 100,
+                     200);
+  uiHung = true;
+  vex::task::sleep(400);
+  expect(watchdog.stopped(), "stuck display job stopped");
+  expect(runMotion(200, true) == 200, "motion beside a stuck job finished");
+
+  // a motion that stops moving is still stopped, and clears when it finishes
+  int passes = runMotion(1000, false);
+  expect(passes < 1000, "motion that did not move was stopped");
+  expect(!watchdog.stopped(motionWatch), "finished motion cleared");
+
+  printf("%d safe stops, %lu overruns\n", safeStops,
+         (unsigned long)watchdog.overrunCount());
+  driveHung = uiHung = false;
+  stopTask(findTask("latency display"));
+  stopTask(findTask("watchdog"));
+  return 0;
+}
+
+static bool keepGoing(double) { return true; }
+
+int main() {
+  sim::Options options;
+  options.period = sim::autonomousPeriod;
+  options.periodMs = 1000000;
+  options.start.x = 72;
+  options.start.y = 72;
+  options.start.heading = 0;
+  options.sdDirectory = NULL;
+  options.tracePath = NULL;
+  options.traceEveryMs = 1;
+  options.stepsPath = NULL;
+  options.expectPath = NULL;
+  options.echoScreen = false;
+  options.selectorMask = -1;
+
+  sim::start(options);
+  watchdog.setSafeStop(safeStop);
+  motionWatch = watchdog.watch("motion", 300, 1000);
+  startTask("watchdog", sensingTask, pollWatchdog, 10);
+  sim::startTask(runChecks, 7);
+  sim::run(keepGoing);
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
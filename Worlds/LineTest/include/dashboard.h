@@ -0,0 +1,95 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Brain Screen Dashboard                          */
+/*                                                                           */
+/*  A fixed set of text fields drawn into the Brain's back buffer and        */
+/*  flipped onto the screen once per frame. Values are handed in with set()  */
+/*  from a sensor snapshot, never read from devices here, and a field is     */
+/*  only drawn again when its text changes.                                  */
+/*---------------------------------------------------------------------------*/
+
+class Dashboard {
+public:
+  static const int maxFields = 12;
+  static const int textLength = 40;
+
+  Dashboard() : count(0) {}
+
+  // format takes a single double, e.g. "Sonar value: %6.2f"
+  int addField(int x, int y, const char *format) {
+    if (count >= maxFields)
+      return -1;
+
+    Field &field = entries[count];
+    field.x = x;
+    field.y = y;
+    field.format = format;
+    field.value = 0;
+    field.shown[0] = '\0';
+    return count++;
+  }
+
+  void set(int index, double value) {
+    if (index >= 0 && index < count)
+      entries[index].value = value;
+  }
+
+  // Draw the fields that changed and show the frame, returns how many were
+  // drawn. The first call also switches the Brain screen to double buffering.
+  int render(vex::brain &brain) {
+    int drawn = 0;
+
+    for (int i = 0; i < count; i++) {
+      Field &field = entries[i];
+
+      char text[textLength];
+      snprintf(text, sizeof(text), field.format, field.value);
+      if (strcmp(text, field.shown) == 0)
+        continue;
+
+      // pad with spaces to cover whatever was longer last time
+      int length = strlen(text);
+      int shownLength = strlen(field.shown);
+      while (length < shownLength && length < textLength - 1)
+        text[length++] = ' ';
+      text[length] = '\0';
+
+      brain.Screen.printAt(field.x, field.y, text);
+
+      // remember the unpadded text so the padding is not compared next time
+      snprintf(field.shown, sizeof(field.shown), field.format, field.value);
+      drawn++;
+    }
+
+    brain.Screen.render();
+    return drawn;
+  }
+
+  // Forget what is on screen so the next render draws every field
+  void invalidate() {
+    for (int i = 0; i < count; i++)
+      entries[i].shown[0] = '\0';
+  }
+
+private:
+  struct Field {
+    int x;
+    int y;
+    const char *format;
+    double value;
+    char shown[textLength];
+  };
+
+  Field entries[maxFields];
+  int count;
+};
+
+#endif
@@ -1,13 +1,31 @@
 #include "robot-config.h"
+#include "dashboard.h"
 using namespace vex;
 
+// Latest line sensor reading, written by sample() and drawn by sFind()
+volatile int lineValue = 0;
+
+int sample() {
+    while(1) {
+        lineValue = Line.value(vex::analogUnits::range8bit);
+        task::sleep(20);
+    }
+    return 0;
+}
+
+Dashboard dashboard;
+
 int sFind() {
+    int line = dashboard.addField(10, 80, "Line Value: %.0f");
     while(1) {
-        Brain.Screen.printAt( 10, 80, "Line Value: %d", Line.value(vex::analogUnits::range8bit));
+        dashboard.set(line, lineValue);
+        dashboard.render(Brain);
+        task::sleep(100);
     }
+    return 0;
 }
 
 int main() {
+    vex::task read(sample);
     vex::task find(sFind);
 }
-
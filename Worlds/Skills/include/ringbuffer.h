@@ -0,0 +1,67 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------*/
+/*                         Single Producer Ring Buffer                       */
+/*                                                                           */
+/*  One task pushes samples in, one other task pops them out, and neither    */
+/*  ever waits for the other. The writer only moves head and the reader only */
+/*  moves tail, so no lock is needed; a barrier makes sure a slot is filled  */
+/*  before the writer publishes it. When the reader falls behind, new        */
+/*  samples are dropped and counted rather than overwriting ones it may be   */
+/*  copying out.                                                             */
+/*---------------------------------------------------------------------------*/
+
+// size has to be a power of two, one slot is always left empty
+template <typename T, uint32_t size> class RingBuffer {
+public:
+  RingBuffer() : head(0), tail(0), drops(0) {}
+
+  // Writer side only. Returns false and counts a drop when full.
+  bool push(const T &item) {
+    uint32_t h = head;
+    uint32_t next = (h + 1) & mask;
+    if (next == tail) {
+      drops++;
+      return false;
+    }
+
+    slots[h] = item;
+    __sync_synchronize(); // slot written before head moves past it
+    head = next;
+    return true;
+  }
+
+  // Reader side only. Returns false when there is nothing to read.
+  bool pop(T &item) {
+    uint32_t t = tail;
+    if (t == head)
+      return false;
+
+    __sync_synchronize(); // see the slot the writer published
+    item = slots[t];
+    __sync_synchronize(); // copied out before the writer may reuse it
+    tail = (t + 1) & mask;
+    return true;
+  }
+
+  // Either side, the answer may be stale by the time it is used
+  uint32_t count() const { return (head - tail) & mask; }
+  bool empty() const { return head == tail; }
+  uint32_t capacity() const { return size - 1; }
+  uint32_t dropped() const { return drops; }
+
+private:
+  static const uint32_t mask = size - 1;
+  static_assert(size >= 2 && (size & mask) == 0,
+                "ring size has to be a power of two");
+
+  T slots[size];
+  volatile uint32_t head;
+  volatile uint32_t tail;
+  volatile uint32_t drops;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "tasks.h"
+#include "v5.h"
+#include "v5_vcs.h"
+
+/*---------------------------------------------------------------------------*/
+/*                                 Watchdog                                  */
+/*                                                                           */
+/*  Anything that has to keep happening gets a watch with a deadline: a      */
+/*  periodic job has to finish a pass, a motion has to keep moving the       */
+/*  wheels. A watch that goes past its deadline is logged as an overrun with */
+/*  the time and its name. If it stays stuck past its stop time the safe     */
+/*  stop runs and stopped(id) turns true until the watch checks in again, so */
+/*  a motion loop knows to give up. A periodic job that has been stopped is  */
+/*  no longer watched, and no longer counts as stopped.                      */
+/*---------------------------------------------------------------------------*/
+
+struct OverrunRecord {
+  uint32_t timeMs; // when the deadline was first missed
+  const char *name;
+  uint32_t lateMs; // how long it had gone without checking in by then
+};
+
+class Watchdog {
+public:
+  static const int maxWatches = 12;
+  static const int logSize = 32;
+
+  Watchdog()
+      : watches(0), overruns(0), safeStop(NULL), enabled(NULL),
+        stopping(false) {}
+
+  // Runs when a watch passes its stop time, should stop every motor
+  void setSafeStop(void (*stop)(void)) { safeStop = stop; }
+
+  // Deadlines are not checked while this returns false, e.g. when disabled
+  void setEnabled(bool (*isEnabled)(void)) { enabled = isEnabled; }
+
+  // deadlineMs is how long the watched code may go without checking in,
+  // stopAfterMs how long before the robot is stopped, 0 to only log it
+  int watch(const char *name, uint32_t deadlineMs, uint32_t stopAfterMs) {
+    if (watches >= maxWatches)
+      return (-1);
+
+    Watch &w = entries[watches];
+    w.name = name;
+    w.deadlineMs = deadlineMs;
+    w.stopAfterMs = stopAfterMs;
+    w.taskSlot = -1;
+    w.armed = false;
+    w.missed = false;
+    w.stopped = false;
+    w.lastCheckIn = 0;
+    w.position = 0;
+    return (watches++);
+  }
+
+  // Watches a periodic job, it checks in every time it finishes a pass
+  int watchTask(int slot, uint32_t deadlineMs, uint32_t stopAfterMs) {
+    if (slot < 0)
+      return (-1);
+
+    int id = watch(periodicTasks[slot].name, deadlineMs, stopAfterMs);
+    if (id >= 0)
+      entries[id].taskSlot = slot;
+    return (id);
+  }
+
+  void start(int id, double position = 0) {
+    if (id < 0)
+      return;
+    entries[id].position = position;
+    entries[id].armed = true;
+    checkIn(id);
+  }
+
+  void checkIn(int id) {
+    if (id < 0)
+      return;
+    Watch &w = entries[id];
+    w.lastCheckIn = vex::timer::system();
+    w.missed = false;
+    if (w.stopped) {
+      w.stopped = false;
+      stopping = anyStopped();
+    }
+  }
+
+  // Only counts as checking in if position moved at least minChange
+  void progress(int id, double position, double minChange) {
+    if (id < 0 || fabs(position - entries[id].position) < minChange)
+      return;
+    entries[id].position = position;
+    checkIn(id);
+  }
+
+  void finish(int id) {
+    if (id < 0)
+      return;
+    checkIn(id);
+    entries[id].armed = false;
+  }
+
+  // Checks every deadline, called regularly from the watchdog job
+  void poll() {
+    if (enabled != NULL && !enabled())
+      return;
+
+    uint32_t now = vex::timer::system();
+
+    for (int i = 0; i < watches; i++) {
+      Watch &w = entries[i];
+
+      uint32_t last = w.lastCheckIn;
+      bool armed = w.armed;
+      if (w.taskSlot >= 0) {
+        last = periodicTasks[w.taskSlot].lastPass;
+        armed = periodicTasks[w.taskSlot].running;
+        if (last != w.lastCheckIn) {
+          w.lastCheckIn = last;
+          w.missed = false;
+          if (w.stopped) {
+            w.stopped = false;
+            stopping = anyStopped();
+          }
+        }
+      }
+
+      if (!armed) {
+        // a job stopped on purpose cannot be stuck any more
+        if (w.stopped) {
+          w.stopped = false;
+          stopping = anyStopped();
+        }
+        continue;
+      }
+
+      uint32_t quiet = now - last;
+      if (quiet > w.deadlineMs && !w.missed) {
+        w.missed = true;
+        record(now, w.name, quiet);
+      }
+
+      if (w.stopAfterMs != 0 && quiet > w.stopAfterMs && !w.stopped) {
+        w.stopped = true;
+        stopping = true;
+        if (safeStop != NULL)
+          safeStop();
+      }
+    }
+  }
+
+  // Whether this watch went past its stop time, or any watch did
+  bool stopped(int id) const { return id >= 0 && entries[id].stopped; }
+  bool stopped() const { return stopping; }
+  uint32_t overrunCount() const { return overruns; }
+
+  // Most recent first, index 0 is the latest overrun
+  const OverrunRecord &overrun(int index) const {
+    return log[(overruns - 1 - index) % logSize];
+  }
+
+  int loggedOverruns() const {
+    return overruns < (uint32_t)logSize ? overruns : logSize;
+  }
+
+  // Shows the overrun count and the latest few overruns from screen row y
+  void print(vex::brain &brain, int y, int rows) const {
+    char line[64];
+    snprintf(line, sizeof(line), "overruns: %lu   ", (unsigned long)overruns);
+    brain.Screen.printAt(10, y, line);
+
+    for (int i = 0; i < rows && i < loggedOverruns(); i++) {
+      const OverrunRecord &r = overrun(i);
+      snprintf(line, sizeof(line), "%7.2fs %-16s %5lums   ", r.timeMs / 1000.0,
+               r.name, (unsigned long)r.lateMs);
+      brain.Screen.printAt(10, y + 20 * (i + 1), line);
+    }
+  }
+
+  // Writes the logged overruns as csv, returns bytes written
+  int32_t save(vex::brain &brain, const char *name) const {
+    static char text[logSize * 48 + 32];
+    int length = snprintf(text, sizeof(text), "time_ms,name,late_ms\n");
+    for (int i = loggedOverruns() - 1; i >= 0; i--) {
+      const OverrunRecord &r = overrun(i);
+      length += snprintf(text + length, sizeof(text) - length, "%lu,%s,%lu\n",
+                         (unsigned long)r.timeMs, r.name,
+                         (unsigned long)r.lateMs);
+    }
+
+    if (!brain.SDcard.isInserted())
+      return 0;
+    return brain.SDcard.savefile(name, (uint8_t *)text, length);
+  }
+
+private:
+  struct Watch {
+    const char *name;
+    uint32_t deadlineMs;
+    uint32_t stopAfterMs;
+    int taskSlot;
+    volatile bool armed;
+    volatile bool missed;
+    volatile bool stopped;
+    volatile uint32_t lastCheckIn;
+    double position;
+  };
+
+  Watch entries[maxWatches];
+  int watches;
+  OverrunRecord log[logSize];
+  uint32_t overruns;
+  void (*safeStop)(void);
+  bool (*enabled)(void);
+  volatile bool stopping;
+
+  void record(uint32_t now, const char *name, uint32_t late) {
+    OverrunRecord &r = log[overruns % logSize];
+    r.timeMs = now;
+    r.name = name;
+    r.lateMs = late;
+    overruns++;
+  }
+
+  bool anyStopped() const {
+    for (int i = 0; i < watches; i++)
+      if (entries[i].stopped)
+        return true;
+    return false;
+  }
+};
+
+#endif
@@ -1,18 +1,118 @@
 #include "algorithm"
 #include "math.h"
 #include "robot-config.h"
+#include "dashboard.h"
+#include "profiler.h"
+#include "ringbuffer.h"
+#include "seqlock.h"
+#include "tasks.h"
+#include "watchdog.h"
 #include "string"
 
 #define waitUntil(CONDITION) while (!(CONDITION))
 
 using namespace vex;
 
+/*
+#################################################################################################
+########################################Robot State#####################################################
+##########################################################################################################
+*/
+
+// Everything the routine, the screen and the log read from the devices.
+// sampleRobot() is the only place these are read; everyone else copies the
+// latest published state out of robotState.
+struct RobotState {
+  uint32_t timeMs;
+
+  // drive encoders in deg, velocities in rpm, currents in amps
+  float lf, lb, rf, rb;
+  float lfVelocity, lbVelocity, rfVelocity, rbVelocity;
+  float lfCurrent, lbCurrent, rfCurrent, rbCurrent;
+
+  float heading;  // gyro, deg
+  float sonar;    // in
+  float line;     // 8 bit reflectivity
+  float flywheel; // average of both flywheel motors, rpm
+};
+
+Seqlock<RobotState> robotState;
+
+// Every state in order for the logging job, sized for over a second of them
+RingBuffer<RobotState, 128> sampleLog;
+
+const int samplePeriod = 10;
+
+RobotState latestState() { return robotState.read(); }
+
+bool sampleRobot() {
+  RobotState s;
+  s.timeMs = vex::timer::system();
+
+  s.lf = lf.rotation(rotationUnits::deg);
+  s.lb = lb.rotation(rotationUnits::deg);
+  s.rf = rf.rotation(rotationUnits::deg);
+  s.rb = rb.rotation(rotationUnits::deg);
+
+  s.lfVelocity = lf.velocity(velocityUnits::rpm);
+  s.lbVelocity = lb.velocity(velocityUnits::rpm);
+  s.rfVelocity = rf.velocity(velocityUnits::rpm);
+  s.rbVelocity = rb.velocity(velocityUnits::rpm);
+
+  s.lfCurrent = lf.current(currentUnits::amp);
+  s.lbCurrent = lb.current(currentUnits::amp);
+  s.rfCurrent = rf.current(currentUnits::amp);
+  s.rbCurrent = rb.current(currentUnits::amp);
+
+  s.heading = Gyro.value(rotationUnits::deg);
+  s.sonar = Sonar.distance(distanceUnits::in);
+  s.line = Line.value(analogUnits::range8bit);
+  s.flywheel =
+      (fw.velocity(velocityUnits::rpm) + fw2.velocity(velocityUnits::rpm)) / 2;
+
+  robotState.publish(s);
+  sampleLog.push(s);
+  return true;
+}
+
 /*
 #################################################################################################
 ########################################ACCELERATION#####################################################
 ##########################################################################################################
 */
 
+// Watches every motion for getting stuck
+Watchdog watchdog;
+int motionWatch = -1;
+
+// ms a motion may go without the wheels moving before it is logged, and
+// before the robot is stopped and the motion abandoned
+const uint32_t motionDeadline = 300;
+const uint32_t motionStopAfter = 1000;
+
+// Everything off, the drive held where it is
+void safeStop() {
+  lf.stop(brakeType::brake);
+  lb.stop(brakeType::brake);
+  rf.stop(brakeType::brake);
+  rb.stop(brakeType::brake);
+  fw.stop(brakeType::coast);
+  fw2.stop(brakeType::coast);
+  in.stop(brakeType::brake);
+  arm.stop(brakeType::hold);
+}
+
+bool watchdogStep() {
+  watchdog.poll();
+  return true;
+}
+
+// Total wheel travel in degrees, goes up whichever way the wheels turn
+double driveTravel() {
+  RobotState s = latestState();
+  return std::abs(s.lf) + std::abs(s.lb) + std::abs(s.rf) + std::abs(s.rb);
+}
+
 // A minimum velocity is necessary. This could also be done per command instead
 // of globally.
 double minimum_velocity = 50.0;
@@ -35,6 +135,9 @@ double decreasing_speed(double ending_point, double current_position) {
 // robot in a straight line for that distance using a trapezoidal motion profile
 // controlled by increasing_speed, decreasing_speed, and maxVelocity
 void forward(double distanceIn, double maxVelocity) {
+  PROFILE("forward");
+  static int forwardPass = profiler.scope("forward pass");
+
   // record nominal wheel circumference
   static const double circumference = 3.14159 * 4;
 
@@ -67,15 +170,19 @@ void forward(double distanceIn, double maxVelocity) {
   double rightBStartPoint = rb.rotation(rotationUnits::rev);
   double rightBEndPoint = rightBStartPoint + wheelRevs;
 
+  watchdog.start(motionWatch, driveTravel());
+
   // execute motion profile
-  while ((direction * (rf.rotation(rotationUnits::rev) - rightStartPoint) <
-          direction * wheelRevs) ||
-         (direction * (lf.rotation(rotationUnits::rev) - leftStartPoint) <
-          direction * wheelRevs) ||
-         (direction * (lb.rotation(rotationUnits::rev) - leftBStartPoint) <
-          direction * wheelRevs) ||
-         (direction * (rb.rotation(rotationUnits::rev) - rightBStartPoint) <
-          direction * wheelRevs)) {
+  while (!watchdog.stopped(motionWatch) &&
+         ((direction * (rf.rotation(rotationUnits::rev) - rightStartPoint) <
+           direction * wheelRevs) ||
+          (direction * (lf.rotation(rotationUnits::rev) - leftStartPoint) <
+           direction * wheelRevs) ||
+          (direction * (lb.rotation(rotationUnits::rev) - leftBStartPoint) <
+           direction * wheelRevs) ||
+          (direction * (rb.rotation(rotationUnits::rev) - rightBStartPoint) <
+           direction * wheelRevs))) {
+    ProfileScope pass(forwardPass);
 
     // set right motor speed to minimum of increasing function, decreasing
     // function, and max velocity, based on current position
@@ -139,7 +246,12 @@ void forward(double distanceIn, double maxVelocity) {
     } else {
       rb.stop(brakeType::brake);
     }
+
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    pass.stop();
+    yieldControl();
   }
+  watchdog.finish(motionWatch);
 }
 
 void forward(double distanceIn) {
@@ -163,6 +275,9 @@ double tdecreasing_speed(double ending_point, double current_position) {
 }
 
 void turn(double distanceIn, double maxVelocity) {
+  PROFILE("turn");
+  static int turnPass = profiler.scope("turn pass");
+
   static const double circumference = 360;
   double direction2 = distanceIn > 0 ? -1 : 1;
   double direction3 = distanceIn > 0 ? 1 : -1;
@@ -188,14 +303,18 @@ void turn(double distanceIn, double maxVelocity) {
   double rightBStartPoint = rb.rotation(rotationUnits::rev);
   double rightBEndPoint = rightBStartPoint + wheelRevs2;
 
-  while ((direction2 * (rf.rotation(rotationUnits::rev) - rightStartPoint) <
-          direction2 * wheelRevs2) ||
-         (direction3 * (lf.rotation(rotationUnits::rev) - leftStartPoint) <
-          direction3 * wheelRevs3) ||
-         (direction3 * (lb.rotation(rotationUnits::rev) - leftBStartPoint) <
-          direction3 * wheelRevs3) ||
-         (direction2 * (rb.rotation(rotationUnits::rev) - rightBStartPoint) <
-          direction2 * wheelRevs2)) {
+  watchdog.start(motionWatch, driveTravel());
+
+  while (!watchdog.stopped(motionWatch) &&
+         ((direction2 * (rf.rotation(rotationUnits::rev) - rightStartPoint) <
+           direction2 * wheelRevs2) ||
+          (direction3 * (lf.rotation(rotationUnits::rev) - leftStartPoint) <
+           direction3 * wheelRevs3) ||
+          (direction3 * (lb.rotation(rotationUnits::rev) - leftBStartPoint) <
+           direction3 * wheelRevs3) ||
+          (direction2 * (rb.rotation(rotationUnits::rev) - rightBStartPoint) <
+           direction2 * wheelRevs2))) {
+    ProfileScope pass(turnPass);
     if (direction2 * (rf.rotation(rotationUnits::rev) - rightStartPoint) <
         direction2 * wheelRevs2) {
       rf.setVelocity(
@@ -255,7 +374,12 @@ void turn(double distanceIn, double maxVelocity) {
     } else {
       rb.stop(brakeType::brake);
     }
+
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    pass.stop();
+    yieldControl();
   }
+  watchdog.finish(motionWatch);
   lf.stop(brakeType::brake);
   lb.stop(brakeType::brake);
   rf.stop(brakeType::brake);
@@ -294,12 +418,18 @@ void turnR(int tdistance, int tspeed, int twait) {
   lb.resetRotation();
   vex::task::sleep(150);
 
-  while (std::abs(lb.rotation(vex::rotationUnits::deg)) < tdistance) {
+  watchdog.start(motionWatch, driveTravel());
+
+  while (!watchdog.stopped(motionWatch) &&
+         std::abs(lb.rotation(vex::rotationUnits::deg)) < tdistance) {
     lf.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     lb.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     rf.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     rb.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    yieldControl();
   }
+  watchdog.finish(motionWatch);
   lf.stop(vex::brakeType::coast);
   lb.stop(vex::brakeType::coast);
   rf.stop(vex::brakeType::coast);
@@ -311,29 +441,44 @@ void turnL(int tdistance, int tspeed, int twait) {
   lb.resetRotation();
   vex::task::sleep(150);
 
-  while (std::abs(lb.rotation(vex::rotationUnits::deg)) < tdistance) {
+  watchdog.start(motionWatch, driveTravel());
+
+  while (!watchdog.stopped(motionWatch) &&
+         std::abs(lb.rotation(vex::rotationUnits::deg)) < tdistance) {
     lf.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     lb.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     rf.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     rb.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    yieldControl();
   }
+  watchdog.finish(motionWatch);
   lf.stop(vex::brakeType::coast);
   lb.stop(vex::brakeType::coast);
   rf.stop(vex::brakeType::coast);
   rb.stop(vex::brakeType::coast);
 }
 
+// The gyro and sonar moves stop on a threshold, so a reading that jumps past
+// the target still ends them. latestState() is up to samplePeriod old, which
+// costs at most one sample of travel past the target: 0.02 in for the skills
+// run's 10 rpm sonarmove.
 void gyroL(int tdistance, int tspeed, int twait) {
   vex::task::sleep(twait);
   Gyro.startCalibration();
   vex::task::sleep(1300);
 
-  while (Gyro.value(rotationUnits::deg) > tdistance) {
+  watchdog.start(motionWatch, driveTravel());
+
+  while (!watchdog.stopped(motionWatch) && latestState().heading > tdistance) {
     lf.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     lb.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     rf.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     rb.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    yieldControl();
   }
+  watchdog.finish(motionWatch);
 
   lf.stop(vex::brakeType::coast);
   lb.stop(vex::brakeType::coast);
@@ -346,12 +491,17 @@ void gyroR(int tdistance, int tspeed, int twait) {
   Gyro.startCalibration();
   vex::task::sleep(1300);
 
-  while (Gyro.value(rotationUnits::deg) < tdistance) {
+  watchdog.start(motionWatch, driveTravel());
+
+  while (!watchdog.stopped(motionWatch) && latestState().heading < tdistance) {
     lf.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     lb.spin(vex::directionType::fwd, tspeed, vex::velocityUnits::rpm);
     rf.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
     rb.spin(vex::directionType::fwd, -tspeed, vex::velocityUnits::rpm);
+    watchdog.progress(motionWatch, driveTravel(), 1);
+    yieldControl();
   }
+  watchdog.finish(motionWatch);
 
   lf.stop(vex::brakeType::coast);
   lb.stop(vex::brakeType::coast);
@@ -412,41 +562,64 @@ void reset(int totalTime, int speed) {
 
 int sonarmove(int sdistance, int sspeed) {
   vex::task::sleep(200);
-  if (Sonar.distance(vex::distanceUnits::in) > sdistance) {
-    while (Sonar.distance(vex::distanceUnits::in) > sdistance) {
+  if (latestState().sonar > sdistance) {
+    watchdog.start(motionWatch, driveTravel());
+
+    while (!watchdog.stopped(motionWatch) && latestState().sonar > sdistance) {
       lf.spin(vex::directionType::rev, sspeed, vex::velocityUnits::rpm);
       lb.spin(vex::directionType::rev, sspeed, vex::velocityUnits::rpm);
       rf.spin(vex::directionType::rev, sspeed, vex::velocityUnits::rpm);
       rb.spin(vex::directionType::rev, sspeed, vex::velocityUnits::rpm);
+      watchdog.progress(motionWatch, driveTravel(), 1);
+      yieldControl();
     }
+    watchdog.finish(motionWatch);
     stopB();
   }
 
-  else if (Sonar.distance(vex::distanceUnits::in) < sdistance) {
-    while (Sonar.distance(vex::distanceUnits::in) < sdistance) {
+  else if (latestState().sonar < sdistance) {
+    watchdog.start(motionWatch, driveTravel());
+
+    while (!watchdog.stopped(motionWatch) && latestState().sonar < sdistance) {
       lf.spin(vex::directionType::fwd, sspeed, vex::velocityUnits::rpm);
       lb.spin(vex::directionType::fwd, sspeed, vex::velocityUnits::rpm);
       rf.spin(vex::directionType::fwd, sspeed, vex::velocityUnits::rpm);
       rb.spin(vex::directionType::fwd, sspeed, vex::velocityUnits::rpm);
+      watchdog.progress(motionWatch, driveTravel(), 1);
+      yieldControl();
     }
+    watchdog.finish(motionWatch);
     stopB();
   }
 
   return (0);
 }
 
+// Whether the line reading has got to value, coming from below or above
+bool lineReached(int value, bool rising) {
+  float line = latestState().line;
+  return rising ? line >= value : line <= value;
+}
+
+// Drives until the line sensor reads lValue. The reading can step past any
+// one value between samples, so it is waited on to cross lValue from the
+// side it started on rather than to equal it.
 int lineMove(int lValue, int sspeed) {
   vex::task::sleep(200);
-  if (!(Line.value(analogUnits::range8bit) == lValue)) {
-    while (Line.value(vex::analogUnits::range8bit) != lValue) {
+  float start = latestState().line;
+  if (start != lValue) {
+    bool rising = start < lValue;
+    watchdog.start(motionWatch, driveTravel());
+
+    while (!watchdog.stopped(motionWatch) && !lineReached(lValue, rising)) {
       lf.spin(vex::directionType::fwd, sspeed, vex::velocityUnits::rpm);
       lb.spin(vex::directionType::fwd, sspeed, vex::velocityUnits::rpm);
       rf.spin(vex::directionType::fwd, sspeed, vex::velocityUnits::rpm);
       rb.spin(vex::directionType::fwd, sspeed, vex::velocityUnits::rpm);
-      Brain.Screen.printAt(10, 80, "Line Value: %d",
-                           Line.value(vex::analogUnits::range8bit));
-      task::sleep(20);
+      watchdog.progress(motionWatch, driveTravel(), 1);
+      yieldControl();
     }
+    watchdog.finish(motionWatch);
     stopB();
   }
   return (0);
@@ -459,19 +632,85 @@ void moveForever(int speed) {
   rb.spin(vex::directionType::fwd, speed, vex::velocityUnits::rpm);
 }
 
-int sfind() {
-  while (1) {
-    Brain.Screen.printAt(10, 20, "L value: %f",
-                         lf.rotation(vex::rotationUnits::deg));
-    Brain.Screen.printAt(10, 40, "R value: %f",
-                         lf.rotation(vex::rotationUnits::deg));
-    Brain.Screen.printAt(10, 80, "Sonar value: %f",
-                         Sonar.distance(vex::distanceUnits::in));
+/*
+#################################################################################################
+########################################Telemetry#####################################################
+##########################################################################################################
+*/
+
+const int framePeriod = 100;
+const int logPeriod = 50;
+
+// Drains the sample log into csv text for samples.csv, until the text is full
+char sampleCsv[256 * 1024];
+int sampleCsvLength = 0;
+
+bool logSamples() {
+  RobotState s;
+  while (sampleLog.pop(s)) {
+    char line[96];
+    int length = snprintf(
+        line, sizeof(line), "%lu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.0f,%.0f\n",
+        (unsigned long)s.timeMs, s.lf, s.lb, s.rf, s.rb, s.heading, s.sonar,
+        s.line, s.flywheel);
+    if (sampleCsvLength + length >= (int)sizeof(sampleCsv))
+      continue;
+    memcpy(sampleCsv + sampleCsvLength, line, length);
+    sampleCsvLength += length;
   }
+  return true;
+}
+
+void saveSamples() {
+  if (Brain.SDcard.isInserted())
+    Brain.SDcard.savefile("samples.csv", (uint8_t *)sampleCsv,
+                          sampleCsvLength);
+}
+
+Dashboard dashboard;
+int leftField, rightField, lineField, sonarField, headingField, flywheelField,
+    overrunField;
+
+void setupDashboard() {
+  leftField = dashboard.addField(10, 20, "L value: %.1f");
+  rightField = dashboard.addField(10, 40, "R value: %.1f");
+  lineField = dashboard.addField(10, 60, "Line value: %.0f");
+  sonarField = dashboard.addField(10, 80, "Sonar value: %.1f");
+  headingField = dashboard.addField(10, 100, "Heading: %.1f");
+  flywheelField = dashboard.addField(10, 120, "Flywheel: %.0f");
+  overrunField = dashboard.addField(10, 160, "Overruns: %.0f");
+}
+
+// Draws the latest state, one frame per call
+bool sfind() {
+  RobotState s = latestState();
+  dashboard.set(leftField, s.lf);
+  dashboard.set(rightField, s.rf);
+  dashboard.set(lineField, s.line);
+  dashboard.set(sonarField, s.sonar);
+  dashboard.set(headingField, s.heading);
+  dashboard.set(flywheelField, s.flywheel);
+  dashboard.set(overrunField, watchdog.overrunCount());
+  dashboard.render(Brain);
+  return true;
 }
 
 int main() {
-  vex::task sFind(sfind);
+  watchdog.setSafeStop(safeStop);
+  motionWatch = watchdog.watch("motion", motionDeadline, motionStopAfter);
+  startTask("watchdog", sensingTask, watchdogStep, 10);
+
+  setupDashboard();
+  watchdog.watchTask(
+      startTask("sensors", sensingTask, sampleRobot, samplePeriod), 60, 0);
+  watchdog.watchTask(startTask("dashboard", uiTask, sfind, framePeriod), 500,
+                     0);
+  sampleCsvLength =
+      snprintf(sampleCsv, sizeof(sampleCsv),
+               "time_ms,lf_deg,lb_deg,rf_deg,rb_deg,heading_deg,sonar_in,"
+               "line,flywheel_rpm\n");
+  watchdog.watchTask(
+      startTask("sample log", loggingTask, logSamples, logPeriod), 500, 0);
 
   task::sleep(20);
 
@@ -486,6 +725,21 @@ int main() {
   turn(-275, 70);
   task::sleep(200);
 
+  watchdog.save(Brain, "overruns.csv");
+  profiler.save(Brain, "profile.csv");
+
+  // once both jobs have seen they are stopped, main is the only reader of the
+  // sample log and the profile takes over the screen
+  stopTask(findTask("sample log"));
+  stopTask(findTask("dashboard"));
+  task::sleep(framePeriod);
+  logSamples();
+  saveSamples();
+
+  Brain.Screen.clearScreen();
+  profiler.print(Brain, 20, 11);
+  Brain.Screen.render();
+
   // fwStart(440);
   // armUp();
 